@@ -9,6 +9,7 @@ public class PuppetMasterTarget : TargetRules
 	{
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
+		bWithPushModel = true;
 		ExtraModuleNames.Add("PuppetMaster");
 	}
 }
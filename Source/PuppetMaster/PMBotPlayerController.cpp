@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMBotPlayerController.h"
+
+#include "PMCharacter.h"
+#include "PMGameMode.h"
+
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "TimerManager.h"
+
+void APMBotPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// the server copy of a bot is just a regular player, only the client drives it
+	if (IsLocalController())
+	{
+		const float FirstDelay = ThinkInterval + FMath::FRandRange(0.f, ThinkJitter);
+		GetWorldTimerManager().SetTimer(ThinkTimerHandle, this, &APMBotPlayerController::Think, FirstDelay);
+	}
+}
+
+void APMBotPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(ThinkTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APMBotPlayerController::Think()
+{
+	const APMGameState* GameState = GetWorld()->GetGameState<APMGameState>();
+	APMPlayerState* MyPlayerState = GetPlayerState<APMPlayerState>();
+
+	if (GameState && MyPlayerState)
+	{
+		if (GameState->InMatchState(EMatchState::WaitingToStart))
+		{
+			MyPlayerState->SetReady();
+		}
+		else if (GameState->InMatchState(EMatchState::Investigation) && IsValid(SimulatedPawn) && SimulatedPawn->IsAlive())
+		{
+			APMCharacter* Target = (FMath::FRand() < FollowChance) ? PickFollowTarget() : nullptr;
+			if (Target)
+			{
+				SetFollowTarget(Target);
+			}
+			else
+			{
+				MoveSomewhere();
+			}
+		}
+	}
+
+	GetWorldTimerManager().SetTimer(ThinkTimerHandle, this, &APMBotPlayerController::Think, ThinkInterval + FMath::FRandRange(0.f, ThinkJitter));
+}
+
+void APMBotPlayerController::MoveSomewhere()
+{
+	if (ScriptedDestinations.Num() > 0)
+	{
+		SetNewMoveDestination(ScriptedDestinations[NextScriptedDestination]);
+		NextScriptedDestination = (NextScriptedDestination + 1) % ScriptedDestinations.Num();
+		return;
+	}
+
+	// clients have no navmesh, the server's path finding sorts out unreachable points
+	const FVector2D Offset = FMath::RandPointInCircle(MoveRadius);
+	SetNewMoveDestination(SimulatedPawn->GetActorLocation() + FVector(Offset, 0.f));
+}
+
+APMCharacter* APMBotPlayerController::PickFollowTarget() const
+{
+	TArray<APMCharacter*, TInlineAllocator<16>> Candidates;
+	for (TActorIterator<APMCharacter> It(GetWorld()); It; ++It)
+	{
+		if ((*It != SimulatedPawn) && It->IsAlive())
+		{
+			Candidates.Add(*It);
+		}
+	}
+
+	return (Candidates.Num() > 0) ? Candidates[FMath::RandRange(0, Candidates.Num() - 1)] : nullptr;
+}
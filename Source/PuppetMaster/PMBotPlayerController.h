@@ -0,0 +1,56 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMPlayerController.h"
+
+#include "PMBotPlayerController.generated.h"
+
+/**
+ * Player controller for headless load test clients. Instead of reading mouse input it readies up and then keeps
+ * issuing the same move and follow requests a player would, so a dedicated server can be loaded with dozens of
+ * -nullrhi clients. The game mode hands it out to clients joining with the PMBot url option.
+ */
+UCLASS(config = Game)
+class APMBotPlayerController : public APMPlayerController
+{
+	GENERATED_BODY()
+
+protected:
+
+	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void Think();
+
+	void MoveSomewhere();
+
+	/** Random living puppet other than our own, or null. */
+	APMCharacter* PickFollowTarget() const;
+
+	/** Seconds between decisions, each randomized by up to ThinkJitter so bots don't all fire on the same frame. */
+	UPROPERTY(config)
+	float ThinkInterval = 1.f;
+
+	UPROPERTY(config)
+	float ThinkJitter = 0.5f;
+
+	/** Chance of following another puppet rather than walking to a point. */
+	UPROPERTY(config)
+	float FollowChance = 0.2f;
+
+	/** Random destinations are picked within this distance of the puppet. */
+	UPROPERTY(config)
+	float MoveRadius = 2000.f;
+
+	/** When set, bots walk these points in order instead of picking random ones. */
+	UPROPERTY(config)
+	TArray<FVector> ScriptedDestinations;
+
+private:
+
+	FTimerHandle ThinkTimerHandle;
+
+	int32 NextScriptedDestination = 0;
+
+};
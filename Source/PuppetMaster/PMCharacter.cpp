@@ -2,24 +2,42 @@
 
 #include "PMCharacter.h"
 
+#include "PMCharacterPool.h"
+#include "PMCorpseSubsystem.h"
+#include "PMLineOfSightComponent.h"
+#include "PMMatch.h"
+#include "PMPathSubsystem.h"
+#include "PMPlanarMovementComponent.h"
+#include "PMProximitySubsystem.h"
 #include "PMPlayerController.h" // for playerstate
+#include "PMSignificanceSubsystem.h"
+#include "PMVisibilitySubsystem.h"
+#include "PuppetMaster.h"
 
 #include "DrawDebugHelpers.h"
-#include "Camera/CameraComponent.h"
+#include "Engine/ActorChannel.h"
 #include "Components/DecalComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Engine/World.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
-#include "GameFramework/SpringArmComponent.h"
 #include "Materials/Material.h"
 #include "Navigation/PathFollowingComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 #include "UObject/ConstructorHelpers.h"
 
+DECLARE_CYCLE_STAT(TEXT("Character Tick"), STAT_PMCharacterTick, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Character PreReplication"), STAT_PMCharacterPreReplication, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Follow Path Update"), STAT_PMFollowPathUpdate, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Follow Finished"), STAT_PMFollowFinished, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Follow Requests"), STAT_PMActiveFollows, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Kills"), STAT_PMPendingKills, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Character Updates Replicated"), STAT_PMCharacterUpdates, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Character Bytes Replicated"), STAT_PMCharacterBytes, STATGROUP_PuppetMaster);
+
 APMCharacter::APMCharacter(const FObjectInitializer& OI)
-	: Super(OI)
+	: Super(OI.SetDefaultSubobjectClass<UPMPlanarMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for player capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -39,19 +57,7 @@ APMCharacter::APMCharacter(const FObjectInitializer& OI)
 	GetCharacterMovement()->bConstrainToPlane = true;
 	GetCharacterMovement()->bSnapToPlaneAtStart = true;
 
-	// Create a camera boom...
-	CameraBoomComponent = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoomComponent->SetupAttachment(RootComponent);
-	CameraBoomComponent->SetUsingAbsoluteRotation(true); // Don't want arm to rotate when character does
-	CameraBoomComponent->TargetArmLength = 800.f;
-	CameraBoomComponent->SetRelativeRotation(FRotator(-60.f, 0.f, 0.f));
-	CameraBoomComponent->bDoCollisionTest = false; // Don't want to pull camera in when it collides with level
-	CameraBoomComponent->bEnableCameraLag = true;
-
-	// Create a camera...
-	CameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("TopDownCamera"));
-	CameraComponent->SetupAttachment(CameraBoomComponent, USpringArmComponent::SocketName);
-	CameraComponent->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+	LineOfSightComponent = CreateDefaultSubobject<UPMLineOfSightComponent>(TEXT("LineOfSight"));
 
 	// Create a decal in the world to show the cursor's location
 // 	CursorToWorld = CreateDefaultSubobject<UDecalComponent>("CursorToWorld");
@@ -64,46 +70,122 @@ APMCharacter::APMCharacter(const FObjectInitializer& OI)
 // 	CursorToWorld->DecalSize = FVector(16.0f, 32.0f, 32.0f);
 // 	CursorToWorld->SetRelativeRotation(FRotator(90.0f, 0.0f, 0.0f).Quaternion());
 
-	// Activate ticking in order to update the cursor every frame.
+	// only ticks to draw the local player's path, see BecomeViewTarget
 	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
 void APMCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	ACharacter::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(APMCharacter, ReplicatedPath);
-	DOREPLIFETIME(APMCharacter, Health);
-	DOREPLIFETIME(APMCharacter, bIncapacitated);
+	// these change a handful of times per match, they're marked dirty where they do
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMCharacter, ReplicatedPath, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMCharacter, Health, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMCharacter, bIncapacitated, Params);
 }
 
 void APMCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
 {
+	SCOPE_CYCLE_COUNTER(STAT_PMCharacterPreReplication);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, CharacterPreReplication);
+
 	Super::PreReplication(ChangedPropertyTracker);
 
-// 	ReplicatedPath.Reset();
-// 	if (IsValid(PathFollowingComponent) && PathFollowingComponent->GetPath().IsValid())
-// 	{
-// 		int32 CurrentPathIndex = PathFollowingComponent->GetCurrentPathIndex();
-// 		const TArray<FNavPathPoint>& NavPoints = PathFollowingComponent->GetPath()->GetPathPoints();
-// 		ReplicatedPath.Reset(NavPoints.Num());
-// 		for (int32 i = 0; i < NavPoints.Num(); ++i)
-// 		{
-// 			if (i > CurrentPathIndex)
-// 			{
-// 				const FNavPathPoint& NavPoint = NavPoints[i];
-// 				ReplicatedPath.Add(NavPoint.Location);
-// 			}
-// 		}
-// 	}
+	// only the unwalked part of the path is sent, and only what changed since last time
+	const bool bPathChanged = (IsValid(PathFollowingComponent) && PathFollowingComponent->GetPath().IsValid())
+		? ReplicatedPath.SetRemainingPath(PathFollowingComponent->GetPath()->GetPathPoints(), PathFollowingComponent->GetCurrentPathIndex())
+		: ReplicatedPath.Clear();
+
+	if (bPathChanged)
+	{
+		PM_MARK_PROPERTY_DIRTY(APMCharacter, ReplicatedPath);
+	}
+
+	PushModelValidator.Validate(*this);
+}
+
+bool APMCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	if (GetWorld()->GetSubsystem<UPMVisibilitySubsystem>()->IsHiddenFrom(RealViewer, *this))
+	{
+		return false;
+	}
+
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+bool APMCharacter::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
+{
+	const bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
+
+	// by now the bunch holds everything this update sends for us to this connection, an empty one is dropped unsent
+	const int32 NumBytes = Bunch->GetNumBytes();
+	if (NumBytes > 0)
+	{
+		INC_DWORD_STAT(STAT_PMCharacterUpdates);
+		INC_DWORD_STAT_BY(STAT_PMCharacterBytes, NumBytes);
+		CSV_CUSTOM_STAT(PuppetMaster, CharacterBytes, NumBytes, ECsvCustomStatOp::Accumulate);
+	}
+
+	return bWroteSomething;
 }
 
 void APMCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	Health = HealthMax;
+	if (HasAuthority())
+	{
+		GetWorld()->GetSubsystem<UPMVisibilitySubsystem>()->RegisterCharacter(*this);
+		GetWorld()->GetSubsystem<UPMProximitySubsystem>()->RegisterCharacter(*this);
+
+		PositionHistory.Record(GetWorld()->GetTimeSeconds(), FVector2D(GetActorLocation()));
+		GetRootComponent()->TransformUpdated.AddUObject(this, &APMCharacter::RecordPosition);
+	}
+
+	// only matters to whoever draws the crowd
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		GetWorld()->GetSubsystem<UPMSignificanceSubsystem>()->RegisterCharacter(*this);
+	}
+}
+
+void APMCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UPMVisibilitySubsystem* Visibility = GetWorld()->GetSubsystem<UPMVisibilitySubsystem>();
+	if (HasAuthority() && Visibility)
+	{
+		Visibility->UnregisterCharacter(*this);
+	}
+
+	UPMProximitySubsystem* Proximity = GetWorld()->GetSubsystem<UPMProximitySubsystem>();
+	if (HasAuthority() && Proximity)
+	{
+		Proximity->UnregisterCharacter(*this);
+	}
+
+	UPMSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UPMSignificanceSubsystem>();
+	if (Significance)
+	{
+		Significance->UnregisterCharacter(*this);
+	}
+
+	UPMCorpseSubsystem* Corpses = GetWorld()->GetSubsystem<UPMCorpseSubsystem>();
+	if (bIncapacitated && Corpses)
+	{
+		Corpses->RemoveCorpse(*this);
+	}
+
+	if (Match)
+	{
+		Match->RemoveCharacter(*this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void APMCharacter::PossessedBy(AController* NewController)
@@ -116,26 +198,96 @@ void APMCharacter::PossessedBy(AController* NewController)
 	// playerstate isn't set yet at this point
 }
 
+void APMCharacter::RecordPosition(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// nobody saw the puppet anywhere in between
+	if (Teleport != ETeleportType::None)
+	{
+		PositionHistory.Reset();
+	}
+
+	PositionHistory.Record(GetWorld()->GetTimeSeconds(), FVector2D(GetActorLocation()));
+}
+
+void APMCharacter::UnPossessed()
+{
+	// the controller may be pooled and handed to another puppet
+	StopFollowing();
+	PathFollowingComponent = nullptr;
+
+	Super::UnPossessed();
+}
+
 void APMCharacter::Tick(float DeltaSeconds)
 {
+	SCOPE_CYCLE_COUNTER(STAT_PMCharacterTick);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, CharacterTick);
+
     Super::Tick(DeltaSeconds);
 
-// 	if (ReplicatedPath.Num() > 0)
-// 	{
-// 		CursorToWorld->SetVisibility(true);
-// 		CursorToWorld->SetWorldLocation(ReplicatedPath.Last());
-// 	}
-// 	else
-// 	{
-// 		CursorToWorld->SetVisibility(false);
-// 	}
-// 
-// 	FVector PrevPoint = GetActorLocation();
-// 	for (const FVector& CurrentPoint : ReplicatedPath)
-// 	{
-// 		DrawDebugLine(GetWorld(), PrevPoint, CurrentPoint, FColor::Green, false, -1.f, 1, 5.f);
-// 		PrevPoint = CurrentPoint;
-// 	}
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		TArray<FVector> Points;
+		ReplicatedPath.GetPoints(GetActorLocation().Z, Points);
+
+		FVector PrevPoint = GetActorLocation();
+		for (const FVector& CurrentPoint : Points)
+		{
+			DrawDebugLine(GetWorld(), PrevPoint, CurrentPoint, FColor::Green, false, -1.f, 1, 5.f);
+			PrevPoint = CurrentPoint;
+		}
+	}
+}
+
+FVector APMCharacter::GetLocationAt(float Time) const
+{
+	const FVector Location = GetActorLocation();
+	return FVector(PositionHistory.GetLocationAt(Time, GetWorld()->GetTimeSeconds(), FVector2D(Location)), Location.Z);
+}
+
+float APMCharacter::GetVisionRadius() const
+{
+	return LineOfSightComponent->VisionRadius;
+}
+
+TArray<FVector> APMCharacter::GetRemainingPath() const
+{
+	TArray<FVector> Points;
+	ReplicatedPath.GetPoints(GetActorLocation().Z, Points);
+	return Points;
+}
+
+void APMCharacter::BecomeViewTarget(APlayerController* PC)
+{
+	// before Super, the Blueprint's view target events still use them
+	if (const APMPlayerController* PMPlayerController = Cast<APMPlayerController>(PC))
+	{
+		CameraComponent = PMPlayerController->GetCameraComponent();
+		CameraBoomComponent = PMPlayerController->GetCameraBoomComponent();
+	}
+
+	Super::BecomeViewTarget(PC);
+
+	// only the local player's puppet needs its line of sight and path drawn
+	if (PC->IsLocalController())
+	{
+		LineOfSightComponent->EnableVisualization();
+		SetActorTickEnabled(true);
+	}
+}
+
+void APMCharacter::EndViewTarget(APlayerController* PC)
+{
+	if (PC->IsLocalController())
+	{
+		LineOfSightComponent->DisableVisualization();
+		SetActorTickEnabled(false);
+	}
+
+	Super::EndViewTarget(PC);
+
+	CameraComponent = nullptr;
+	CameraBoomComponent = nullptr;
 }
 
 void APMCharacter::MoveTo(const FVector& Location)
@@ -149,11 +301,31 @@ void APMCharacter::MoveTo(const FVector& Location)
 	// We need to issue move command only if far enough in order for walk animation to play correctly
 	if ((Distance > 120.0f))
 	{
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(GetController(), Location);
+		// the new order counts from the click, not from when its path comes in
+		StopFollowing();
+
+		UPMPathSubsystem* Paths = GetWorld()->GetSubsystem<UPMPathSubsystem>();
+		Paths->FindPath(*GetController(), Location, FPMPathReady::CreateUObject(this, &APMCharacter::OnMovePathReady, ++PathRequestSerial, Location));
+	}
+}
+
+void APMCharacter::OnMovePathReady(FNavPathSharedPtr Path, uint32 RequestSerial, FVector Goal)
+{
+	// we may have been given another order or died while the query ran
+	if ((RequestSerial != PathRequestSerial) || !Path.IsValid() || !GetController() || !IsAlive() || !PathFollowingComponent)
+	{
+		return;
+	}
+
+	if (PathFollowingComponent->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		PathFollowingComponent->AbortMove(*GetController(), FPathFollowingResultFlags::ForcedScript | FPathFollowingResultFlags::NewRequest, FAIRequestID::CurrentRequest, EPathFollowingVelocityMode::Keep);
 	}
+
+	PathFollowingComponent->RequestMove(FAIMoveRequest(Goal), Path);
 }
 
-void APMCharacter::MoveToActorAndPerformAction(APMCharacter& Target)
+void APMCharacter::MoveToActorAndPerformAction(APMCharacter& Target, float SeenAtTime)
 {
 	check(HasAuthority());
 	check(GetController());
@@ -162,31 +334,200 @@ void APMCharacter::MoveToActorAndPerformAction(APMCharacter& Target)
 	check(&Target != this);
 	check(PathFollowingComponent);
 
+	StopFollowing();
+
+	// already within reach when the player clicked, no need to walk up to them
+	if (GetWorld()->GetSubsystem<UPMProximitySubsystem>()->IsInInteractionRangeAt(*this, Target, SeenAtTime))
+	{
+		GetController()->StopMovement();
+		PerformActionOn(Target);
+		return;
+	}
+
 	CurrentTarget = &Target;
 
+	INC_DWORD_STAT(STAT_PMActiveFollows);
+	if (!Target.IsIncapacitated())
+	{
+		bFollowingToKill = true;
+		INC_DWORD_STAT(STAT_PMPendingKills);
+	}
+
 	PathFollowingComponent->AbortMove(*GetController(), FPathFollowingResultFlags::NewRequest, FAIRequestID::CurrentRequest, EPathFollowingVelocityMode::Keep);
 	FollowHandle = PathFollowingComponent->OnRequestFinished.AddLambda
 	(
 		[this](FAIRequestID RequestID, const FPathFollowingResult& Result)
 		{
-			if (Result.Code == EPathFollowingResult::Success)
+			SCOPE_CYCLE_COUNTER(STAT_PMFollowFinished);
+
+			// the goal may have been reached at the end of a path the target has since walked away from
+			APMCharacter* Victim = CurrentTarget.Get();
+			const bool bInRange = IsValid(Victim) && GetWorld()->GetSubsystem<UPMProximitySubsystem>()->IsInInteractionRange(*this, *Victim);
+
+			StopFollowing();
+
+			if ((Result.Code == EPathFollowingResult::Success) && bInRange)
 			{
-				APMCharacter* Victim = Cast<APMCharacter>(CurrentTarget.Get());
-				if (IsValid(Victim) && !Victim->IsIncapacitated())
-				{
-					Victim->TryToKill(*this, 1);
-				}
-				else if (IsValid(Victim) && Victim->IsIncapacitated() && Victim->IsAlive())
-				{
-					Victim->Revived();
-				}
+				PerformActionOn(*Victim);
 			}
-
-			CurrentTarget.Reset();
-			FollowHandle.Reset();
 		}
 	);
-	UAIBlueprintHelperLibrary::SimpleMoveToActor(GetController(), &Target);
+
+	FollowGoal = Target.GetActorLocation();
+	bFollowPathPending = true;
+
+	UPMPathSubsystem* Paths = GetWorld()->GetSubsystem<UPMPathSubsystem>();
+	Paths->FindPath(*GetController(), FollowGoal, FPMPathReady::CreateUObject(this, &APMCharacter::OnFollowPathReady, ++PathRequestSerial));
+}
+
+void APMCharacter::OnFollowPathReady(FNavPathSharedPtr Path, uint32 RequestSerial)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMFollowPathUpdate);
+
+	if (RequestSerial != PathRequestSerial)
+	{
+		return;
+	}
+
+	bFollowPathPending = false;
+
+	APMCharacter* Target = CurrentTarget.Get();
+	if (!IsValid(Target) || !Path.IsValid() || !GetController() || !IsAlive() || !PathFollowingComponent)
+	{
+		StopFollowing();
+		return;
+	}
+
+	const FNavPathSharedPtr CurrentPath = PathFollowingComponent->GetPath();
+	if (GetWorldTimerManager().IsTimerActive(FollowTimerHandle) && CurrentPath.IsValid() && (PathFollowingComponent->GetStatus() != EPathFollowingStatus::Idle))
+	{
+		// swap the route under the running request so the action still fires when it finishes
+		CurrentPath->GetPathPoints() = Path->GetPathPoints();
+		CurrentPath->SetIsPartial(Path->IsPartial());
+		CurrentPath->DoneUpdating(ENavPathUpdateType::GoalMoved);
+	}
+	else if (PathFollowingComponent->RequestMove(FAIMoveRequest(Target), Path).IsValid())
+	{
+		GetWorldTimerManager().SetTimer(FollowTimerHandle, this, &APMCharacter::UpdateFollowPath, FollowUpdateInterval, true);
+	}
+	else
+	{
+		StopFollowing();
+	}
+}
+
+void APMCharacter::UpdateFollowPath()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMFollowPathUpdate);
+
+	APMCharacter* Target = CurrentTarget.Get();
+	if (!IsValid(Target) || !GetController() || !PathFollowingComponent)
+	{
+		return;
+	}
+
+	// the action fires as soon as we're within reach rather than when the path runs out
+	if (GetWorld()->GetSubsystem<UPMProximitySubsystem>()->IsInInteractionRange(*this, *Target))
+	{
+		StopFollowing();
+		GetController()->StopMovement();
+		PerformActionOn(*Target);
+		return;
+	}
+
+	if (bFollowPathPending)
+	{
+		return;
+	}
+
+	const FVector TargetLocation = Target->GetActorLocation();
+	if (FVector::DistSquared2D(TargetLocation, FollowGoal) < FMath::Square(FollowRepathDistance))
+	{
+		return;
+	}
+
+	FollowGoal = TargetLocation;
+
+	// most of the time the target only took a few steps and the route there still holds
+	UPMPathSubsystem* Paths = GetWorld()->GetSubsystem<UPMPathSubsystem>();
+	const FNavPathSharedPtr CurrentPath = PathFollowingComponent->GetPath();
+	if (CurrentPath.IsValid() && Paths->TryUpdatePathGoal(*GetController(), *CurrentPath, TargetLocation))
+	{
+		return;
+	}
+
+	bFollowPathPending = true;
+	Paths->FindPath(*GetController(), TargetLocation, FPMPathReady::CreateUObject(this, &APMCharacter::OnFollowPathReady, ++PathRequestSerial));
+}
+
+void APMCharacter::PerformActionOn(APMCharacter& Target)
+{
+	if (Target.IsAlive() && !Target.IsIncapacitated())
+	{
+		Target.TryToKill(*this, 1);
+	}
+	else if (Target.IsAlive() && Target.IsIncapacitated() && Match->GetRules().Revive(Target.MatchSlot))
+	{
+		Target.Revived();
+	}
+}
+
+void APMCharacter::StopMoving()
+{
+	check(HasAuthority());
+
+	StopFollowing();
+
+	if (GetController())
+	{
+		GetController()->StopMovement();
+	}
+}
+
+void APMCharacter::StopFollowing()
+{
+	if (FollowHandle.IsValid())
+	{
+		DEC_DWORD_STAT(STAT_PMActiveFollows);
+		if (PathFollowingComponent)
+		{
+			PathFollowingComponent->OnRequestFinished.Remove(FollowHandle);
+		}
+	}
+
+	if (bFollowingToKill)
+	{
+		DEC_DWORD_STAT(STAT_PMPendingKills);
+		bFollowingToKill = false;
+	}
+
+	CurrentTarget.Reset();
+	FollowHandle.Reset();
+	bFollowPathPending = false;
+
+	GetWorldTimerManager().ClearTimer(FollowTimerHandle);
+}
+
+void APMCharacter::SetFrozen(bool bFrozen)
+{
+	check(HasAuthority());
+
+	if (bFrozen)
+	{
+		if (GetController())
+		{
+			GetController()->StopMovement();
+		}
+		GetCharacterMovement()->StopMovementImmediately();
+
+		// make sure the stopped position goes out before the channel goes dormant
+		ForceNetUpdate();
+		SetNetDormancy(DORM_DormantAll);
+	}
+	else
+	{
+		SetNetDormancy(DORM_Awake);
+	}
 }
 
 bool APMCharacter::TryToKill(const APMCharacter& Perpetrator, int32 HitPoints)
@@ -194,18 +535,23 @@ bool APMCharacter::TryToKill(const APMCharacter& Perpetrator, int32 HitPoints)
 	check(HasAuthority());
 	check(GetController());
 	check(IsAlive());
+	check(Match);
 
-	AdjustHealth(Perpetrator, -HitPoints);
+	const EHitOutcome Outcome = Match->GetRules().Hit(MatchSlot, HitPoints);
+	UpdateHealth();
 
-	if (IsAlive())
+	switch (Outcome)
 	{
+	case EHitOutcome::PassedOut:
 		PassOut();
 		return false;
-	}
-	else
-	{
+
+	case EHitOutcome::Died:
 		Die(Perpetrator);
 		return true;
+
+	default:
+		return false;
 	}
 }
 
@@ -214,8 +560,96 @@ void APMCharacter::AdjustHealth(const AActor& DamageCauser, int32 AdjustAmount)
 	check(HasAuthority());
 	check(GetController());
 	check(IsAlive());
+	check(Match);
+
+	Match->GetRules().AdjustHealth(MatchSlot, AdjustAmount);
+	UpdateHealth();
+}
+
+void APMCharacter::Eject()
+{
+	check(HasAuthority());
+	check(Match && !Match->GetRules().IsAlive(MatchSlot));
+
+	UpdateHealth();
+	StopFollowing();
+	Incapacitated();
+
+	if (GetController())
+	{
+		GetWorld()->GetSubsystem<UPMCharacterPool>()->ReleaseController(*GetController());
+	}
+}
+
+void APMCharacter::SetMatch(APMMatch* InMatch, int32 InMatchSlot)
+{
+	Match = InMatch;
+	MatchSlot = InMatchSlot;
+
+	if (Match && (MatchSlot != INDEX_NONE))
+	{
+		UpdateHealth();
+	}
+}
+
+void APMCharacter::EnterPool()
+{
+	check(HasAuthority());
+
+	StopFollowing();
+
+	if (Match)
+	{
+		Match->RemoveCharacter(*this);
+		Match = nullptr;
+		MatchSlot = INDEX_NONE;
+	}
+
+	GetWorld()->GetSubsystem<UPMVisibilitySubsystem>()->UnregisterCharacter(*this);
+	GetWorld()->GetSubsystem<UPMProximitySubsystem>()->UnregisterCharacter(*this);
+
+	// clients revive their copy through OnRep_Incapacitated
+	if (bIncapacitated)
+	{
+		bIncapacitated = false;
+		PM_MARK_PROPERTY_DIRTY(APMCharacter, bIncapacitated);
+
+		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		GetWorld()->GetSubsystem<UPMCorpseSubsystem>()->RemoveCorpse(*this);
+	}
+
+	Health = GetClass()->GetDefaultObject<APMCharacter>()->Health;
+	PM_MARK_PROPERTY_DIRTY(APMCharacter, Health);
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	GetMovementComponent()->Deactivate();
+
+	SetFrozen(true);
+}
+
+void APMCharacter::LeavePool(const FTransform& Transform)
+{
+	check(HasAuthority());
 
-	Health = FMath::Clamp(Health + AdjustAmount, 0, HealthMax);
+	SetFrozen(false);
+
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	GetMovementComponent()->Activate();
+
+	GetWorld()->GetSubsystem<UPMVisibilitySubsystem>()->RegisterCharacter(*this);
+	GetWorld()->GetSubsystem<UPMProximitySubsystem>()->RegisterCharacter(*this);
+}
+
+void APMCharacter::UpdateHealth()
+{
+	// a frozen puppet still has to tell clients about this
+	FlushNetDormancy();
+
+	Health = Match->GetRules().GetHealth(MatchSlot);
+	PM_MARK_PROPERTY_DIRTY(APMCharacter, Health);
 }
 
 void APMCharacter::PassOut()
@@ -225,6 +659,8 @@ void APMCharacter::PassOut()
 	check(IsAlive());
 
 	Incapacitated();
+
+	GetWorld()->GetAuthGameMode<APMGameModeBase>()->HandlePuppetChanged(*this);
 }
 
 void APMCharacter::Die(const APMCharacter& Perpetrator)
@@ -233,12 +669,18 @@ void APMCharacter::Die(const APMCharacter& Perpetrator)
 
 	Incapacitated();
 
-	GetController()->Destroy();
+	GetWorld()->GetSubsystem<UPMCharacterPool>()->ReleaseController(*GetController());
+
+	Match->SyncPlayers();
+	GetWorld()->GetAuthGameMode<APMGameModeBase>()->HandlePuppetChanged(*this);
 }
 
 void APMCharacter::Incapacitated()
 {
+	FlushNetDormancy();
+
 	bIncapacitated = true;
+	PM_MARK_PROPERTY_DIRTY(APMCharacter, bIncapacitated);
 
 	OnIncapacitated.Broadcast();
 
@@ -246,20 +688,27 @@ void APMCharacter::Incapacitated()
 	GetMovementComponent()->Deactivate();
 
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-
+	GetWorld()->GetSubsystem<UPMCorpseSubsystem>()->AddCorpse(*this);
 }
 
 void APMCharacter::Revived()
 {
+	FlushNetDormancy();
+
 	bIncapacitated = false;
+	PM_MARK_PROPERTY_DIRTY(APMCharacter, bIncapacitated);
 
 	GetMovementComponent()->Activate();
 
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	GetMesh()->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	GetWorld()->GetSubsystem<UPMCorpseSubsystem>()->RemoveCorpse(*this);
 
 	OnRevived.Broadcast();
+
+	if (HasAuthority())
+	{
+		GetWorld()->GetAuthGameMode<APMGameModeBase>()->HandlePuppetChanged(*this);
+	}
 }
 
 void APMCharacter::OnRep_Incapacitated()
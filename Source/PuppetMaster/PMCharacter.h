@@ -2,6 +2,10 @@
 
 #pragma once
 
+#include "PMPositionHistory.h"
+#include "PMPushModel.h"
+#include "PMReplicatedPath.h"
+
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
@@ -30,30 +34,81 @@ public:
 	bool IsAlive() const { return Health > 0; }
 	bool IsIncapacitated() const { return bIncapacitated; }
 
+	float GetVisionRadius() const;
+
+	/** What is left of the puppet's current path, in walking order. */
+	UFUNCTION(BlueprintPure)
+	TArray<FVector> GetRemainingPath() const;
+
 	void MoveTo(const FVector& Location);
-	void MoveToActorAndPerformAction(APMCharacter& Victim);
+	/** SeenAtTime is when the player saw the puppets where they were, see IsInInteractionRangeAt. */
+	void MoveToActorAndPerformAction(APMCharacter& Victim, float SeenAtTime);
+
+	/** Server only, drops whatever the puppet was walking to, e.g. when its player disconnected. */
+	void StopMoving();
 
+	/** Server only, where the puppet was at a recent server time, for judging clicks the way the player saw them. */
+	FVector GetLocationAt(float Time) const;
+
+	/** Health and incapacitation are decided by the match's rules, the puppet shows the result. */
 	bool TryToKill(const APMCharacter& Perpetrator, int32 HitPoints);
 	void AdjustHealth(const AActor& DamageCauser, int32 AdjustAmount);
 
+	/** Voted out of the match. */
+	void Eject();
+
+	/** Stops the puppet and puts it to sleep for replication while the match has no use for movement. */
+	void SetFrozen(bool bFrozen);
+
+	/** The match the puppet was spawned for and the slot of its player in the match's rules, server only. */
+	class APMMatch* GetMatch() const { return Match; }
+	int32 GetMatchSlot() const { return MatchSlot; }
+	void SetMatch(class APMMatch* InMatch, int32 InMatchSlot);
+
+	/** Server only, see UPMCharacterPool. Puts the puppet back the way it spawned, out of its match and out of sight. */
+	void EnterPool();
+	void LeavePool(const FTransform& Transform);
+
 protected:
 
 	APMCharacter(const FObjectInitializer& OI);
 
 	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+	bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	bool ReplicateSubobjects(class UActorChannel* Channel, class FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
 
 	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	void PossessedBy(AController* NewController) override;
+	void UnPossessed() override;
+
+	void RecordPosition(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
 
 	void Tick(float DeltaSeconds) override;
 
+	void BecomeViewTarget(APlayerController* PC) override;
+	void EndViewTarget(APlayerController* PC) override;
+
 	void PassOut();
 	void Die(const APMCharacter& Perpetrator);
 
 	void Incapacitated();
 	void Revived();
 
+	/** Copies the puppet's health out of the match's rules. */
+	void UpdateHealth();
+
+	void OnMovePathReady(FNavPathSharedPtr Path, uint32 RequestSerial, FVector Goal);
+	void OnFollowPathReady(FNavPathSharedPtr Path, uint32 RequestSerial);
+
+	/** Keeps the path to the followed puppet up to date as it walks away. */
+	void UpdateFollowPath();
+	void StopFollowing();
+
+	/** Kills a standing puppet or revives a passed out one. */
+	void PerformActionOn(APMCharacter& Target);
+
 	UPROPERTY(BlueprintAssignable)
 	FIncapacitated OnIncapacitated;
 
@@ -71,22 +126,57 @@ private:
 	UPROPERTY(Replicated, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	int32 Health = 1;
 
-	// #todo
-	int32 HealthMax = 2;
+	UPROPERTY(Replicated)
+	FPMReplicatedPath ReplicatedPath;
 
-	UPROPERTY(Replicated, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-	TArray<FVector_NetQuantize> ReplicatedPath;
+	/** Server only, recorded as the puppet moves. */
+	FPMPositionHistory PositionHistory;
+
+	/**
+	 * Kept until TopDownCharacter is resaved without its Activate Camera and Deactivate Camera nodes. They point at the
+	 * local player's rig while the puppet is its view target and are null otherwise.
+	 */
+	UPROPERTY(Transient, VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true", DeprecatedProperty, DeprecationMessage = "Puppets carry no camera, use APMPlayerController::GetCameraComponent."))
+	class UCameraComponent* CameraComponent = nullptr;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-	class UCameraComponent* CameraComponent;
+	UPROPERTY(Transient, VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true", DeprecatedProperty, DeprecationMessage = "Puppets carry no camera boom, the local player controller owns it."))
+	class USpringArmComponent* CameraBoomComponent = nullptr;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-	class USpringArmComponent* CameraBoomComponent;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = LineOfSight, meta = (AllowPrivateAccess = "true"))
+	class UPMLineOfSightComponent* LineOfSightComponent;
 
 	UPROPERTY(Transient)
 	class UPathFollowingComponent* PathFollowingComponent = nullptr;
 
+	UPROPERTY(Transient)
+	class APMMatch* Match = nullptr;
+
+	int32 MatchSlot = INDEX_NONE;
+
+	/** Row and column of the puppet in UPMVisibilitySubsystem's matrix, INDEX_NONE while it isn't registered. */
+	int32 VisibilityIndex = INDEX_NONE;
+	friend class UPMVisibilitySubsystem;
+
+	/** How often the path to a followed puppet is checked against where it went. */
+	UPROPERTY(EditDefaultsOnly, Category = Movement)
+	float FollowUpdateInterval = 0.25f;
+
+	/** How far a followed puppet may get from the end of the path before it is updated. */
+	UPROPERTY(EditDefaultsOnly, Category = Movement)
+	float FollowRepathDistance = 100.f;
+
 	TWeakObjectPtr<APMCharacter> CurrentTarget;
 	FDelegateHandle FollowHandle;
+	FTimerHandle FollowTimerHandle;
+	FVector FollowGoal = FVector::ZeroVector;
+	bool bFollowPathPending = false;
+
+	/** Following a standing puppet, which ends in a kill attempt. */
+	bool bFollowingToKill = false;
+
+	/** Path queries answer late, only the latest one gets to move us. */
+	uint32 PathRequestSerial = 0;
+
+	FPMPushModelValidator PushModelValidator;
 
 };
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMCharacterPool.h"
+
+#include "PMCharacter.h"
+#include "PuppetMaster.h"
+
+#include "GameFramework/Controller.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Characters"), STAT_PMPooledCharacters, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Controllers"), STAT_PMPooledControllers, STATGROUP_PuppetMaster);
+
+APMCharacter* UPMCharacterPool::AcquireCharacter(TSubclassOf<APawn> Class, const FTransform& Transform)
+{
+	for (int32 Index = Characters.Num() - 1; Index >= 0; --Index)
+	{
+		APMCharacter* Character = Characters[Index];
+		if (!IsValid(Character))
+		{
+			Characters.RemoveAtSwap(Index);
+			DEC_DWORD_STAT(STAT_PMPooledCharacters);
+			continue;
+		}
+
+		if (Character->GetClass() != Class)
+		{
+			continue;
+		}
+
+		Characters.RemoveAtSwap(Index);
+		DEC_DWORD_STAT(STAT_PMPooledCharacters);
+
+		Character->LeavePool(Transform);
+
+		if (!Character->GetController())
+		{
+			if (AController* Controller = AcquireController(Character->AIControllerClass))
+			{
+				Controller->Possess(Character);
+			}
+			else
+			{
+				Character->SpawnDefaultController();
+			}
+		}
+
+		return Character;
+	}
+
+	return nullptr;
+}
+
+void UPMCharacterPool::ReleaseCharacter(APMCharacter& Character)
+{
+	check(Character.HasAuthority());
+
+	if (Characters.Num() >= MaxPooled)
+	{
+		Character.Destroy();
+		return;
+	}
+
+	Character.EnterPool();
+
+	Characters.Add(&Character);
+	INC_DWORD_STAT(STAT_PMPooledCharacters);
+}
+
+void UPMCharacterPool::ReleaseController(AController& Controller)
+{
+	Controller.StopMovement();
+	Controller.UnPossess();
+
+	if (Controllers.Num() >= MaxPooled)
+	{
+		Controller.Destroy();
+		return;
+	}
+
+	Controllers.Add(&Controller);
+	INC_DWORD_STAT(STAT_PMPooledControllers);
+}
+
+AController* UPMCharacterPool::AcquireController(TSubclassOf<AController> Class)
+{
+	for (int32 Index = Controllers.Num() - 1; Index >= 0; --Index)
+	{
+		AController* Controller = Controllers[Index];
+		if (!IsValid(Controller) || (Controller->GetClass() == Class))
+		{
+			Controllers.RemoveAtSwap(Index);
+			DEC_DWORD_STAT(STAT_PMPooledControllers);
+
+			if (IsValid(Controller))
+			{
+				return Controller;
+			}
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PMCharacterPool.generated.h"
+
+class AController;
+class APawn;
+class APMCharacter;
+
+/**
+ * Server side pool of puppets and their AI controllers, so a full lobby restarting a match doesn't spawn and
+ * garbage collect a puppet per player. Pooled puppets are hidden, without collision and dormant, so they cost
+ * nothing to keep around on the server or on clients.
+ */
+UCLASS(config = Game)
+class UPMCharacterPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** A pooled puppet of exactly Class placed at Transform and possessed, null if there is none. */
+	APMCharacter* AcquireCharacter(TSubclassOf<APawn> Class, const FTransform& Transform);
+
+	/** Takes the puppet out of its match and parks it, destroys it if the pool is full. */
+	void ReleaseCharacter(APMCharacter& Character);
+
+	/** Unpossesses and parks a dead puppet's controller for the next puppet that needs one. */
+	void ReleaseController(AController& Controller);
+
+private:
+
+	AController* AcquireController(TSubclassOf<AController> Class);
+
+	UPROPERTY(Transient)
+	TArray<APMCharacter*> Characters;
+
+	UPROPERTY(Transient)
+	TArray<AController*> Controllers;
+
+	/** Anything released past this many puppets or controllers is destroyed instead. */
+	UPROPERTY(config)
+	int32 MaxPooled = 64;
+
+};
@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMCorpseSubsystem.h"
+
+#include "PMCharacter.h"
+#include "PuppetMaster.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Settle Corpses"), STAT_PMSettleCorpses, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Settling Corpses"), STAT_PMSettlingCorpses, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frozen Corpses"), STAT_PMFrozenCorpses, STATGROUP_PuppetMaster);
+
+void UPMCorpseSubsystem::AddCorpse(APMCharacter& Character)
+{
+	USkeletalMeshComponent* Mesh = Character.GetMesh();
+	if (Mesh->bNoSkeletonUpdate || Settling.ContainsByPredicate([&Character](const FSettlingCorpse& Corpse) { return Corpse.Character == &Character; }))
+	{
+		return;
+	}
+
+	// the significance subsystem may have slowed or stopped the live mesh, it leaves bodies to us
+	Mesh->SetComponentTickEnabled(true);
+	Mesh->SetComponentTickInterval(0.f);
+
+	// nobody watches a dedicated server's bodies fall
+	if ((GetWorld()->GetNetMode() == NM_DedicatedServer) || (Settling.Num() >= MaxSettling) || !Mesh->GetPhysicsAsset())
+	{
+		Freeze(Character);
+		return;
+	}
+
+	Mesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	Mesh->SetAllBodiesSimulatePhysics(true);
+	Mesh->WakeAllRigidBodies();
+
+	Settling.Add({ &Character, GetWorld()->GetTimeSeconds() + SettleTime });
+	INC_DWORD_STAT(STAT_PMSettlingCorpses);
+}
+
+void UPMCorpseSubsystem::RemoveCorpse(APMCharacter& Character)
+{
+	const int32 NumRemoved = Settling.RemoveAllSwap([&Character](const FSettlingCorpse& Corpse) { return Corpse.Character == &Character; });
+	DEC_DWORD_STAT_BY(STAT_PMSettlingCorpses, NumRemoved);
+
+	USkeletalMeshComponent* Mesh = Character.GetMesh();
+	if (Mesh->bNoSkeletonUpdate)
+	{
+		DEC_DWORD_STAT(STAT_PMFrozenCorpses);
+	}
+
+	Mesh->SetAllBodiesSimulatePhysics(false);
+	Mesh->bNoSkeletonUpdate = false;
+	Mesh->SetComponentTickEnabled(true);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+
+	// ragdolling takes the mesh off the capsule
+	if (Mesh->GetAttachParent() != Character.GetCapsuleComponent())
+	{
+		Mesh->AttachToComponent(Character.GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	}
+	Mesh->SetRelativeLocationAndRotation(Character.GetBaseTranslationOffset(), Character.GetBaseRotationOffset());
+}
+
+void UPMCorpseSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMSettleCorpses);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (int32 Index = Settling.Num() - 1; Index >= 0; --Index)
+	{
+		APMCharacter* Character = Settling[Index].Character.Get();
+		if (Character && (Now < Settling[Index].FreezeTime) && Character->GetMesh()->RigidBodyIsAwake())
+		{
+			continue;
+		}
+
+		Settling.RemoveAtSwap(Index);
+		DEC_DWORD_STAT(STAT_PMSettlingCorpses);
+
+		if (Character)
+		{
+			Freeze(*Character);
+		}
+	}
+}
+
+TStatId UPMCorpseSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPMCorpseSubsystem, STATGROUP_Tickables);
+}
+
+void UPMCorpseSubsystem::Freeze(APMCharacter& Character)
+{
+	USkeletalMeshComponent* Mesh = Character.GetMesh();
+
+	// the bodies stay where they settled for traces, the bones where they were last drawn
+	Mesh->SetAllBodiesSimulatePhysics(false);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	Mesh->SetComponentTickEnabled(false);
+	Mesh->bNoSkeletonUpdate = true;
+
+	INC_DWORD_STAT(STAT_PMFrozenCorpses);
+}
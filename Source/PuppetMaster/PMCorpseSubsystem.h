@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "PMCorpseSubsystem.generated.h"
+
+class APMCharacter;
+
+/**
+ * Keeps bodies cheap however many of them pile up over a match.
+ * A new body ragdolls for SettleTime to fall into a pose, then physics, animation and bone updates are switched off
+ * and it keeps that pose, still hit-testable, until it is revived. At most MaxSettling bodies ragdoll at once, any
+ * more keep the pose they went down in straight away, and dedicated servers never ragdoll at all.
+ */
+UCLASS(config = Game)
+class UPMCorpseSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Called as a puppet passes out or dies, on the server and on clients. */
+	void AddCorpse(APMCharacter& Character);
+
+	/** Gives a revived or removed puppet its live skeleton back. */
+	void RemoveCorpse(APMCharacter& Character);
+
+	// Begin FTickableGameObject interface
+	void Tick(float DeltaTime) override;
+	bool IsTickable() const override { return Settling.Num() > 0; }
+	TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+private:
+
+	void Freeze(APMCharacter& Character);
+
+	struct FSettlingCorpse
+	{
+		TWeakObjectPtr<APMCharacter> Character;
+		float FreezeTime;
+	};
+
+	TArray<FSettlingCorpse> Settling;
+
+	UPROPERTY(config)
+	float SettleTime = 2.f;
+
+	UPROPERTY(config)
+	int32 MaxSettling = 4;
+
+};
@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMFogBenchmarkCommandlet.h"
+
+#include "PMFogOfWar.h"
+#include "PMLineOfSightComponent.h"
+#include "PMVisibility.h"
+#include "PuppetMaster.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/Parse.h"
+
+UPMFogBenchmarkCommandlet::UPMFogBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPMFogBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString ResolutionList = TEXT("256,512");
+	int32 NumUpdates = 2000;
+	int32 NumWalls = 200;
+	float WorldSize = 8000.f;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Resolutions="), ResolutionList);
+	FParse::Value(*Params, TEXT("Updates="), NumUpdates);
+	FParse::Value(*Params, TEXT("Walls="), NumWalls);
+	FParse::Value(*Params, TEXT("WorldSize="), WorldSize);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	const float VisionRadius = GetDefault<UPMLineOfSightComponent>()->VisionRadius;
+	const FVector2D WorldMin(-0.5f * WorldSize, -0.5f * WorldSize);
+
+	FRandomStream Random(Seed);
+	TArray<FPMWallSegment> Walls;
+	for (int32 Index = 0; Index < NumWalls; ++Index)
+	{
+		const FVector2D Start = WorldMin + FVector2D(Random.FRand(), Random.FRand()) * WorldSize;
+		const FVector2D End = Start + FVector2D(Random.FRandRange(-400.f, 400.f), Random.FRandRange(-400.f, 400.f));
+		Walls.Emplace(Start, End);
+	}
+
+	// the same walk for every resolution, polygons are built up front so only the rasterizer is timed
+	TArray<TArray<FVector2D>> Polygons;
+	Polygons.SetNum(NumUpdates);
+	FVector2D Location = FVector2D::ZeroVector;
+	FVector2D Heading(1.f, 0.f);
+	for (TArray<FVector2D>& Polygon : Polygons)
+	{
+		Heading = Heading.GetRotated(Random.FRandRange(-10.f, 10.f));
+		Location += Heading * 10.f;
+		if (FMath::Abs(Location.X) > 0.4f * WorldSize || FMath::Abs(Location.Y) > 0.4f * WorldSize)
+		{
+			Heading = -Location.GetSafeNormal();
+		}
+
+		PMVisibility::ComputeVisibilityPolygon(Location, VisionRadius, 0.f, 2.f * PI, Walls, Polygon);
+	}
+
+	TArray<FString> Resolutions;
+	ResolutionList.ParseIntoArray(Resolutions, TEXT(","));
+	for (const FString& ResolutionString : Resolutions)
+	{
+		const int32 Resolution = FCString::Atoi(*ResolutionString);
+		if (Resolution <= 0)
+		{
+			continue;
+		}
+
+		FPMFogGrid Grid(Resolution, WorldMin, WorldSize);
+		int64 NumDirtyCells = 0;
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (const TArray<FVector2D>& Polygon : Polygons)
+		{
+			NumDirtyCells += Grid.SetVisiblePolygon(Polygon).Area();
+		}
+		const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogPuppetMaster, Display, TEXT("%dx%d: %.1f us per update, %.0f cells uploaded per update (%.1f%% of the texture)"),
+			Resolution, Resolution, 1e6 * ElapsedTime / FMath::Max(NumUpdates, 1), double(NumDirtyCells) / FMath::Max(NumUpdates, 1),
+			100.0 * NumDirtyCells / FMath::Max(NumUpdates, 1) / (Resolution * Resolution));
+	}
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "PMFogBenchmarkCommandlet.generated.h"
+
+/**
+ * Times FPMFogGrid updates headless, for a puppet walking through a room of random walls.
+ * Run with -run=PMFogBenchmark. -Resolutions=256,512 picks the grid sizes, -Updates= how many polygons each one
+ * rasterizes and -Walls=, -WorldSize= and -Seed= the room.
+ */
+UCLASS()
+class UPMFogBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UPMFogBenchmarkCommandlet();
+
+	int32 Main(const FString& Params) override;
+
+};
@@ -0,0 +1,113 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMFogOfWar.h"
+
+FPMFogGrid::FPMFogGrid(int32 InResolution, const FVector2D& InWorldMin, float InWorldSize)
+	: Resolution(InResolution)
+	, WorldMin(InWorldMin)
+	, CellSize(InWorldSize / InResolution)
+{
+	check(Resolution > 0 && CellSize > 0.f);
+
+	Cells.SetNumZeroed(Resolution * Resolution);
+	static_assert(Unexplored == 0, "cells start zeroed");
+}
+
+FIntRect FPMFogGrid::SetVisiblePolygon(TArrayView<const FVector2D> Polygon)
+{
+	const FIntRect NewBounds = GetCellBounds(Polygon);
+
+	// what was visible is only remembered now, the new polygon brings back whatever is still in view
+	for (int32 Y = VisibleBounds.Min.Y; Y < VisibleBounds.Max.Y; ++Y)
+	{
+		uint8* Row = &Cells[Y * Resolution];
+		for (int32 X = VisibleBounds.Min.X; X < VisibleBounds.Max.X; ++X)
+		{
+			Row[X] = (Row[X] == Visible) ? Explored : Row[X];
+		}
+	}
+
+	FillPolygon(Polygon, NewBounds);
+
+	FIntRect Dirty = VisibleBounds;
+	if (IsEmpty(Dirty))
+	{
+		Dirty = NewBounds;
+	}
+	else if (!IsEmpty(NewBounds))
+	{
+		Dirty.Union(NewBounds);
+	}
+
+	VisibleBounds = NewBounds;
+	return Dirty;
+}
+
+FIntRect FPMFogGrid::GetCellBounds(TArrayView<const FVector2D> Polygon) const
+{
+	if (Polygon.Num() < 3)
+	{
+		return FIntRect();
+	}
+
+	FVector2D Min = Polygon[0];
+	FVector2D Max = Polygon[0];
+	for (const FVector2D& Point : Polygon)
+	{
+		Min = FVector2D::Min(Min, Point);
+		Max = FVector2D::Max(Max, Point);
+	}
+
+	const FIntPoint CellMin(FMath::FloorToInt((Min.X - WorldMin.X) / CellSize), FMath::FloorToInt((Min.Y - WorldMin.Y) / CellSize));
+	const FIntPoint CellMax(FMath::CeilToInt((Max.X - WorldMin.X) / CellSize), FMath::CeilToInt((Max.Y - WorldMin.Y) / CellSize));
+
+	FIntRect Bounds(CellMin.ComponentMax(FIntPoint::ZeroValue), CellMax.ComponentMin(FIntPoint(Resolution, Resolution)));
+	return IsEmpty(Bounds) ? FIntRect() : Bounds;
+}
+
+void FPMFogGrid::FillPolygon(TArrayView<const FVector2D> Polygon, const FIntRect& Bounds)
+{
+	if (IsEmpty(Bounds))
+	{
+		return;
+	}
+
+	CellPolygonScratch.Reset(Polygon.Num());
+	for (const FVector2D& Point : Polygon)
+	{
+		CellPolygonScratch.Add((Point - WorldMin) / CellSize);
+	}
+
+	const int32 NumPoints = CellPolygonScratch.Num();
+	for (int32 Y = Bounds.Min.Y; Y < Bounds.Max.Y; ++Y)
+	{
+		const float SampleY = Y + 0.5f;
+
+		CrossingScratch.Reset();
+		for (int32 Index = 0, Prev = NumPoints - 1; Index < NumPoints; Prev = Index++)
+		{
+			const FVector2D& A = CellPolygonScratch[Prev];
+			const FVector2D& B = CellPolygonScratch[Index];
+
+			// half open so a vertex on the sample line is only crossed once
+			if ((A.Y <= SampleY) != (B.Y <= SampleY))
+			{
+				CrossingScratch.Add(A.X + (SampleY - A.Y) / (B.Y - A.Y) * (B.X - A.X));
+			}
+		}
+
+		CrossingScratch.Sort();
+
+		uint8* Row = &Cells[Y * Resolution];
+		for (int32 Index = 0; Index + 1 < CrossingScratch.Num(); Index += 2)
+		{
+			// cells whose centers lie between the crossings
+			const int32 First = FMath::Max(FMath::CeilToInt(CrossingScratch[Index] - 0.5f), Bounds.Min.X);
+			const int32 Last = FMath::Min(FMath::FloorToInt(CrossingScratch[Index + 1] - 0.5f), Bounds.Max.X - 1);
+			if (First <= Last)
+			{
+				FMemory::Memset(Row + First, Visible, Last - First + 1);
+			}
+		}
+	}
+}
@@ -0,0 +1,54 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fog of war as a square grid of bytes over the map, rasterized on the CPU from a visibility polygon.
+ * Cells start Unexplored, are Visible while inside the polygon and drop to Explored once they leave it. An update only
+ * touches the cells around the old and the new polygon and returns that rectangle, so only it has to be uploaded.
+ * Nothing in here needs the engine, so it can be driven headless, see UPMFogBenchmarkCommandlet.
+ */
+class FPMFogGrid
+{
+public:
+
+	static constexpr uint8 Unexplored = 0;
+	static constexpr uint8 Explored = 96;
+	static constexpr uint8 Visible = 255;
+
+	FPMFogGrid() = default;
+	FPMFogGrid(int32 InResolution, const FVector2D& InWorldMin, float InWorldSize);
+
+	/** Replaces the visible area with Polygon, in world space. Returns the cells that changed, empty if none could have. */
+	FIntRect SetVisiblePolygon(TArrayView<const FVector2D> Polygon);
+
+	int32 GetResolution() const { return Resolution; }
+	const FVector2D& GetWorldMin() const { return WorldMin; }
+	float GetWorldSize() const { return Resolution * CellSize; }
+
+	/** Row major, Resolution cells to a row. */
+	const uint8* GetData() const { return Cells.GetData(); }
+	uint8 GetCell(int32 X, int32 Y) const { return Cells[Y * Resolution + X]; }
+
+	static bool IsEmpty(const FIntRect& Rect) { return (Rect.Width() <= 0) || (Rect.Height() <= 0); }
+
+private:
+
+	FIntRect GetCellBounds(TArrayView<const FVector2D> Polygon) const;
+
+	/** Even-odd scanline fill, sampling cell centers. */
+	void FillPolygon(TArrayView<const FVector2D> Polygon, const FIntRect& Bounds);
+
+	TArray<uint8> Cells;
+	TArray<FVector2D> CellPolygonScratch;
+	TArray<float> CrossingScratch;
+
+	int32 Resolution = 0;
+	FVector2D WorldMin = FVector2D::ZeroVector;
+	float CellSize = 1.f;
+
+	/** Every Visible cell lies in here. */
+	FIntRect VisibleBounds;
+};
@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMFogOfWarSubsystem.h"
+
+#include "PMMatch.h"
+#include "PMPlayerController.h"
+#include "PuppetMaster.h"
+
+#include "Async/Async.h"
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fog Rasterize"), STAT_PMFogRasterize, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Fog Upload"), STAT_PMFogUpload, STATGROUP_PuppetMaster);
+
+void UPMFogOfWarSubsystem::Deinitialize()
+{
+	// the job still points at us
+	if (Job.IsValid())
+	{
+		Job.Wait();
+		Job = TFuture<FIntRect>();
+	}
+
+	Super::Deinitialize();
+}
+
+void UPMFogOfWarSubsystem::UpdateVisibility(TArrayView<const FVector2D> Polygon)
+{
+	if (Job.IsValid())
+	{
+		PendingPolygon.Reset();
+		PendingPolygon.Append(Polygon.GetData(), Polygon.Num());
+		bHasPendingPolygon = true;
+		return;
+	}
+
+	JobPolygon.Reset();
+	JobPolygon.Append(Polygon.GetData(), Polygon.Num());
+	StartRasterizing();
+}
+
+void UPMFogOfWarSubsystem::ResetFog()
+{
+	if (Job.IsValid())
+	{
+		Job.Wait();
+		Job = TFuture<FIntRect>();
+	}
+
+	bHasGrid = false;
+	bHasPendingPolygon = false;
+}
+
+void UPMFogOfWarSubsystem::GetFogBounds(FVector2D& OutWorldMin, float& OutWorldSize) const
+{
+	OutWorldMin = Grid.GetWorldMin();
+	OutWorldSize = Grid.GetWorldSize();
+}
+
+void UPMFogOfWarSubsystem::Tick(float DeltaTime)
+{
+	if (Job.IsReady())
+	{
+		FinishRasterizing();
+	}
+}
+
+TStatId UPMFogOfWarSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPMFogOfWarSubsystem, STATGROUP_Tickables);
+}
+
+void UPMFogOfWarSubsystem::InitGrid()
+{
+	const APlayerController* LocalPlayer = GEngine->GetFirstLocalPlayerController(GetWorld());
+	const APMPlayerState* LocalPlayerState = LocalPlayer ? LocalPlayer->GetPlayerState<APMPlayerState>() : nullptr;
+	const APMMatch* Match = LocalPlayerState ? LocalPlayerState->GetMatch() : nullptr;
+	const FVector2D Center = Match ? FVector2D(Match->GetOrigin()) : FVector2D::ZeroVector;
+
+	if (bHasGrid && (Center == GridCenter))
+	{
+		return;
+	}
+
+	Grid = FPMFogGrid(Resolution, Center - FVector2D(0.5f * WorldSize, 0.5f * WorldSize), WorldSize);
+	GridCenter = Center;
+	bHasGrid = true;
+
+	if (!FogTexture)
+	{
+		FogTexture = UTexture2D::CreateTransient(Resolution, Resolution, PF_G8);
+		FogTexture->SRGB = false;
+		FogTexture->Filter = TF_Bilinear;
+		FogTexture->AddressX = TA_Clamp;
+		FogTexture->AddressY = TA_Clamp;
+		FogTexture->UpdateResource();
+	}
+
+	UploadRegion(FIntRect(0, 0, Resolution, Resolution));
+}
+
+void UPMFogOfWarSubsystem::StartRasterizing()
+{
+	InitGrid();
+
+	Job = Async(EAsyncExecution::ThreadPool, [this]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PMFogRasterize);
+		return Grid.SetVisiblePolygon(JobPolygon);
+	});
+}
+
+void UPMFogOfWarSubsystem::FinishRasterizing()
+{
+	const FIntRect Dirty = Job.Get();
+	Job = TFuture<FIntRect>();
+
+	if (!FPMFogGrid::IsEmpty(Dirty))
+	{
+		UploadRegion(Dirty);
+	}
+
+	if (bHasPendingPolygon)
+	{
+		Swap(JobPolygon, PendingPolygon);
+		bHasPendingPolygon = false;
+		StartRasterizing();
+	}
+}
+
+void UPMFogOfWarSubsystem::UploadRegion(const FIntRect& Rect)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMFogUpload);
+
+	// the render thread copies it later, by when the grid may be rasterizing again
+	const int32 Width = Rect.Width();
+	const int32 Height = Rect.Height();
+	uint8* Data = new uint8[Width * Height];
+	for (int32 Row = 0; Row < Height; ++Row)
+	{
+		FMemory::Memcpy(Data + Row * Width, Grid.GetData() + (Rect.Min.Y + Row) * Resolution + Rect.Min.X, Width);
+	}
+
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(Rect.Min.X, Rect.Min.Y, 0, 0, Width, Height);
+	FogTexture->UpdateTextureRegions(0, 1, Region, Width, 1, Data, [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+	{
+		delete[] SrcData;
+		delete Regions;
+	});
+}
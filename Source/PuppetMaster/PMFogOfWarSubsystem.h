@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMFogOfWar.h"
+
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "PMFogOfWarSubsystem.generated.h"
+
+class UTexture2D;
+
+/**
+ * Client side fog of war for the top-down view. The local puppet's visibility polygon, see UPMLineOfSightComponent,
+ * is rasterized into an FPMFogGrid on a worker thread, and the cells that changed go to FogTexture in one region
+ * update. The grid covers WorldSize around the local player's match, materials map it with GetFogBounds.
+ */
+UCLASS(config = Game)
+class UPMFogOfWarSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void Deinitialize() override;
+
+	/** Called with the local puppet's visibility polygon whenever it changes, in world space. */
+	void UpdateVisibility(TArrayView<const FVector2D> Polygon);
+
+	/** Forgets everything explored so far, e.g. for a new match. */
+	UFUNCTION(BlueprintCallable, Category = FogOfWar)
+	void ResetFog();
+
+	/** One byte per cell: 0 unexplored, 96 explored, 255 visible. Null until the local puppet first looks around. */
+	UFUNCTION(BlueprintPure, Category = FogOfWar)
+	UTexture2D* GetFogTexture() const { return FogTexture; }
+
+	UFUNCTION(BlueprintPure, Category = FogOfWar)
+	void GetFogBounds(FVector2D& OutWorldMin, float& OutWorldSize) const;
+
+	// Begin FTickableGameObject interface
+	void Tick(float DeltaTime) override;
+	bool IsTickable() const override { return Job.IsValid(); }
+	TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+private:
+
+	/** Sets the grid up around the local player's match if it isn't already. */
+	void InitGrid();
+
+	void StartRasterizing();
+	void FinishRasterizing();
+	void UploadRegion(const FIntRect& Rect);
+
+	FPMFogGrid Grid;
+	FVector2D GridCenter = FVector2D::ZeroVector;
+	bool bHasGrid = false;
+
+	/** Owns Grid and JobPolygon while valid. */
+	TFuture<FIntRect> Job;
+	TArray<FVector2D> JobPolygon;
+
+	/** Newest polygon that came in while a job was running, only the latest one is worth rasterizing. */
+	TArray<FVector2D> PendingPolygon;
+	bool bHasPendingPolygon = false;
+
+	UPROPERTY(Transient)
+	UTexture2D* FogTexture = nullptr;
+
+	UPROPERTY(config)
+	int32 Resolution = 256;
+
+	UPROPERTY(config)
+	float WorldSize = 8000.f;
+
+};
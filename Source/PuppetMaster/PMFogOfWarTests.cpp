@@ -0,0 +1,212 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMFogOfWar.h"
+
+#include "PMTestHelpers.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PMFogOfWarTests
+{
+	constexpr int32 Resolution = 16;
+	constexpr float CellSize = 10.f;
+
+	// off the origin, so a grid that forgets WorldMin shows
+	const FVector2D WorldMin(100.f, -50.f);
+
+	/** A grid and every cell that was ever inside one of its polygons. */
+	struct FFixture
+	{
+		FPMFogGrid Grid{ Resolution, WorldMin, Resolution * CellSize };
+		TArray<bool> Seen;
+
+		FFixture()
+		{
+			Seen.Init(false, Resolution * Resolution);
+		}
+	};
+
+	/** Polygons are written in cells, one unit to a cell, so the cell centers sit on the halves. */
+	TArray<FVector2D> MakePolygon(std::initializer_list<FVector2D> CellPoints)
+	{
+		TArray<FVector2D> Polygon;
+		for (const FVector2D& Point : CellPoints)
+		{
+			Polygon.Add(WorldMin + Point * CellSize);
+		}
+		return Polygon;
+	}
+
+	TArray<FVector2D> MakeBox(float MinX, float MinY, float MaxX, float MaxY)
+	{
+		return MakePolygon({ FVector2D(MinX, MinY), FVector2D(MaxX, MinY), FVector2D(MaxX, MaxY), FVector2D(MinX, MaxY) });
+	}
+
+	bool IsInRect(const FIntRect& Rect, int32 X, int32 Y)
+	{
+		return (X >= Rect.Min.X) && (X < Rect.Max.X) && (Y >= Rect.Min.Y) && (Y < Rect.Max.Y);
+	}
+
+	/**
+	 * Shows Polygon and checks every cell against the cell centers inside it and the cells seen before, and that every
+	 * cell that changed lies in the returned rectangle. Returns that rectangle.
+	 */
+	FIntRect Update(FAutomationTestBase& Test, const TCHAR* What, FFixture& Fixture, const TArray<FVector2D>& Polygon)
+	{
+		const TArray<uint8> Before(Fixture.Grid.GetData(), Resolution * Resolution);
+		const FIntRect Dirty = Fixture.Grid.SetVisiblePolygon(Polygon);
+
+		if (!FPMFogGrid::IsEmpty(Dirty))
+		{
+			Test.TestTrue(FString::Printf(TEXT("%s: dirty rect inside the grid"), What),
+				(Dirty.Min.X >= 0) && (Dirty.Min.Y >= 0) && (Dirty.Max.X <= Resolution) && (Dirty.Max.Y <= Resolution));
+		}
+
+		int32 NumWrong = 0;
+		int32 NumOutsideDirty = 0;
+		for (int32 Y = 0; Y < Resolution; ++Y)
+		{
+			for (int32 X = 0; X < Resolution; ++X)
+			{
+				const int32 Index = Y * Resolution + X;
+				const bool bInside = (Polygon.Num() >= 3) && PMTestHelpers::IsInsidePolygon(WorldMin + FVector2D(X + 0.5f, Y + 0.5f) * CellSize, Polygon);
+				Fixture.Seen[Index] = Fixture.Seen[Index] || bInside;
+
+				const uint8 Expected = bInside ? FPMFogGrid::Visible : (Fixture.Seen[Index] ? FPMFogGrid::Explored : FPMFogGrid::Unexplored);
+				const uint8 Cell = Fixture.Grid.GetCell(X, Y);
+
+				// one message each is enough to find it, the counts say how bad it is
+				if (Cell != Expected)
+				{
+					if (NumWrong++ == 0)
+					{
+						Test.AddError(FString::Printf(TEXT("%s: cell (%d, %d) is %d, expected %d"), What, X, Y, Cell, Expected));
+					}
+				}
+				if ((Cell != Before[Index]) && (FPMFogGrid::IsEmpty(Dirty) || !IsInRect(Dirty, X, Y)))
+				{
+					if (NumOutsideDirty++ == 0)
+					{
+						Test.AddError(FString::Printf(TEXT("%s: cell (%d, %d) changed outside the dirty rect"), What, X, Y));
+					}
+				}
+			}
+		}
+
+		Test.TestEqual(FString::Printf(TEXT("%s: wrong cells"), What), NumWrong, 0);
+		Test.TestEqual(FString::Printf(TEXT("%s: changed cells outside the dirty rect"), What), NumOutsideDirty, 0);
+
+		return Dirty;
+	}
+
+	/** The first and last Visible cell of a row, INDEX_NONE for both if there is none. Fails if the run has gaps. */
+	FIntPoint GetVisibleRun(FAutomationTestBase& Test, const FPMFogGrid& Grid, int32 Y)
+	{
+		FIntPoint Run(INDEX_NONE, INDEX_NONE);
+		for (int32 X = 0; X < Resolution; ++X)
+		{
+			if (Grid.GetCell(X, Y) == FPMFogGrid::Visible)
+			{
+				Test.TestTrue(FString::Printf(TEXT("Row %d is one run"), Y), (Run.Y == INDEX_NONE) || (Run.Y == X - 1));
+				Run.X = (Run.X == INDEX_NONE) ? X : Run.X;
+				Run.Y = X;
+			}
+		}
+		return Run;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMFogVisibleToExploredTest, "PuppetMaster.FogOfWar.VisibleFallsBackToExplored", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMFogVisibleToExploredTest::RunTest(const FString& Parameters)
+{
+	using namespace PMFogOfWarTests;
+
+	FFixture Fixture;
+
+	const TArray<FVector2D> First = MakeBox(2.3f, 3.3f, 5.7f, 6.7f);
+	TestTrue(TEXT("The first polygon dirties its own cells"), Update(*this, TEXT("First"), Fixture, First) == FIntRect(2, 3, 6, 7));
+
+	const TArray<FVector2D> Away = MakeBox(9.2f, 10.2f, 12.8f, 13.8f);
+	TestTrue(TEXT("Moving away dirties where it was and where it is"), Update(*this, TEXT("Away"), Fixture, Away) == FIntRect(2, 3, 13, 14));
+	TestEqual(TEXT("Left behind"), Fixture.Grid.GetCell(3, 4), FPMFogGrid::Explored);
+
+	// a triangle half over the box it came from
+	const TArray<FVector2D> Overlap = MakePolygon({ FVector2D(7.1f, 8.2f), FVector2D(14.6f, 9.4f), FVector2D(10.3f, 15.2f) });
+	TestTrue(TEXT("Overlapping"), Update(*this, TEXT("Overlap"), Fixture, Overlap) == FIntRect(7, 8, 15, 16));
+
+	TestTrue(TEXT("Nothing in view dirties what was"), Update(*this, TEXT("Blind"), Fixture, TArray<FVector2D>()) == FIntRect(7, 8, 15, 16));
+	TestTrue(TEXT("Nothing in view twice dirties nothing"), FPMFogGrid::IsEmpty(Update(*this, TEXT("Blind again"), Fixture, TArray<FVector2D>())));
+
+	Update(*this, TEXT("Back"), Fixture, First);
+	TestEqual(TEXT("Explored cells come back into view"), Fixture.Grid.GetCell(3, 4), FPMFogGrid::Visible);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMFogVerticesOnScanlineTest, "PuppetMaster.FogOfWar.VerticesOnScanline", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMFogVerticesOnScanlineTest::RunTest(const FString& Parameters)
+{
+	using namespace PMFogOfWarTests;
+
+	// every vertex of the diamond lies on the line through a row of cell centers
+	{
+		FFixture Fixture;
+		Update(*this, TEXT("Diamond"), Fixture, MakePolygon({ FVector2D(8.f, 2.5f), FVector2D(13.f, 7.5f), FVector2D(8.f, 12.5f), FVector2D(3.f, 7.5f) }));
+
+		TestTrue(TEXT("The side vertices cross their row once each"), GetVisibleRun(*this, Fixture.Grid, 7) == FIntPoint(3, 12));
+		TestTrue(TEXT("The top vertex fills nothing"), GetVisibleRun(*this, Fixture.Grid, 2) == FIntPoint(INDEX_NONE, INDEX_NONE));
+		TestTrue(TEXT("The bottom vertex fills nothing"), GetVisibleRun(*this, Fixture.Grid, 12) == FIntPoint(INDEX_NONE, INDEX_NONE));
+		for (int32 Y = 3; Y < 12; ++Y)
+		{
+			TestTrue(FString::Printf(TEXT("Row %d is filled"), Y), GetVisibleRun(*this, Fixture.Grid, Y).X != INDEX_NONE);
+		}
+	}
+
+	// horizontal edges on a row of centers: the row at the top is in, the row at the bottom is out
+	{
+		FFixture Fixture;
+		Update(*this, TEXT("Box on the centers"), Fixture, MakeBox(3.f, 4.5f, 10.f, 8.5f));
+
+		TestTrue(TEXT("Top row"), GetVisibleRun(*this, Fixture.Grid, 4) == FIntPoint(3, 9));
+		TestTrue(TEXT("Bottom row"), GetVisibleRun(*this, Fixture.Grid, 8) == FIntPoint(INDEX_NONE, INDEX_NONE));
+	}
+
+	// a notch whose inner vertex sits on a row of centers, so that row has four crossings
+	{
+		FFixture Fixture;
+		Update(*this, TEXT("Notch"), Fixture, MakePolygon({ FVector2D(2.2f, 2.2f), FVector2D(13.8f, 2.2f), FVector2D(13.8f, 11.8f),
+			FVector2D(8.f, 6.5f), FVector2D(2.2f, 11.8f) }));
+
+		TestTrue(TEXT("Above the notch"), GetVisibleRun(*this, Fixture.Grid, 5) == FIntPoint(2, 13));
+		TestTrue(TEXT("At the tip of the notch"), GetVisibleRun(*this, Fixture.Grid, 6) == FIntPoint(2, 13));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMFogClipsToGridTest, "PuppetMaster.FogOfWar.ClipsToGrid", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMFogClipsToGridTest::RunTest(const FString& Parameters)
+{
+	using namespace PMFogOfWarTests;
+
+	FFixture Fixture;
+
+	TestTrue(TEXT("Too few points dirty nothing"), FPMFogGrid::IsEmpty(Update(*this, TEXT("Line"), Fixture, MakePolygon({ FVector2D(1.f, 1.f), FVector2D(9.f, 9.f) }))));
+	TestTrue(TEXT("Off the grid dirties nothing"), FPMFogGrid::IsEmpty(Update(*this, TEXT("Off the grid"), Fixture, MakeBox(20.f, -9.f, 30.f, 30.f))));
+
+	TestTrue(TEXT("Over the low corner"), Update(*this, TEXT("Low corner"), Fixture, MakeBox(-5.4f, -3.6f, 3.7f, 4.2f)) == FIntRect(0, 0, 4, 5));
+	TestTrue(TEXT("Over the high corner"), Update(*this, TEXT("High corner"), Fixture, MakePolygon({ FVector2D(11.3f, 12.1f), FVector2D(24.f, 9.7f), FVector2D(19.5f, 25.f) }))
+		== FIntRect(0, 0, Resolution, Resolution));
+	TestTrue(TEXT("Over everything"), Update(*this, TEXT("Everything"), Fixture, MakeBox(-40.f, -40.f, 60.f, 60.f)) == FIntRect(0, 0, Resolution, Resolution));
+	TestTrue(TEXT("Leaving the grid dirties where it was"), Update(*this, TEXT("Gone"), Fixture, MakeBox(-30.f, 2.f, -20.f, 8.f)) == FIntRect(0, 0, Resolution, Resolution));
+	TestEqual(TEXT("Everything was seen"), Fixture.Grid.GetCell(Resolution - 1, Resolution - 1), FPMFogGrid::Explored);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
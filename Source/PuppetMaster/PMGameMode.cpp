@@ -2,23 +2,68 @@
 
 #include "PMGameMode.h"
 
+#include "PMBotPlayerController.h"
 #include "PMPlayerController.h"
 #include "PMCharacter.h"
-
+#include "PMCharacterPool.h"
+#include "PMMatch.h"
+#include "PMProximitySubsystem.h"
+#include "PMVoteTracker.h"
+#include "PuppetMaster.h"
+
+#include "Engine/NetDriver.h"
+#include "EngineDefines.h"
+#include "EngineUtils.h"
 #include "GameFramework/GameSession.h"
+#include "GameFramework/PlayerStart.h"
 #include "GameFramework/PlayerState.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
 #include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 #include "UObject/ConstructorHelpers.h"
 
+DECLARE_CYCLE_STAT(TEXT("Handle Match Event"), STAT_PMHandleMatchEvent, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Reset Match"), STAT_PMResetMatch, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Reconnect Player"), STAT_PMReconnectPlayer, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inactive Players"), STAT_PMInactivePlayers, STATGROUP_PuppetMaster);
+
+namespace
+{
+	/** Cell of the Index-th match on a square spiral around the origin, so the first match sits on it. */
+	FIntPoint GetSpiralCell(int32 Index)
+	{
+		// ring R holds the 8R cells around the (2R-1)^2 square inside it
+		const int32 Ring = FMath::CeilToInt((FMath::Sqrt(static_cast<float>(Index + 1)) - 1.f) * 0.5f);
+		if (Ring == 0)
+		{
+			return FIntPoint::ZeroValue;
+		}
+
+		const int32 Side = 2 * Ring;
+		const int32 Step = Index - FMath::Square(Side - 1);
+		const int32 Along = (Step % Side) - Ring + 1;
+
+		switch (Step / Side)
+		{
+		case 0: return FIntPoint(Ring, Along);
+		case 1: return FIntPoint(-Along, Ring);
+		case 2: return FIntPoint(-Ring, -Along);
+		default: return FIntPoint(Along, -Ring);
+		}
+	}
+}
+
 APMGameModeBase::APMGameModeBase()
 {
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.TickInterval = .2f;
+	// the match only moves on timers and player events, see HandleMatchEvent
+	PrimaryActorTick.bCanEverTick = false;
 
 	// use our custom PlayerController class
 	PlayerControllerClass = APMPlayerController::StaticClass();
 	PlayerStateClass = APMPlayerState::StaticClass();
 	GameStateClass = APMGameState::StaticClass();
+	BotPlayerControllerClass = APMBotPlayerController::StaticClass();
 
 }
 
@@ -37,199 +82,767 @@ void APMGameModeBase::InitGameState()
 void APMGameModeBase::StartPlay()
 {
 	Super::StartPlay();
+
+	if (!MatchLevel.IsNull() && (GetMaxMatches() < MaxMatches))
+	{
+		UE_LOG(LogGameMode, Warning, TEXT("Only %d of MaxMatches %d fit inside the world %.0f apart"), GetMaxMatches(), MaxMatches, MatchSpacing);
+	}
 }
 
-namespace
+void APMGameModeBase::HandlePlayerReadyChanged(const APMPlayerState& Player)
 {
-	void ForEachPlayer(UWorld& World, const TFunction<void(APMPlayerController& PlayerController)>& DoThis)
+	APMMatch* Match = Player.GetMatch();
+	if (!Match)
 	{
-		for (FConstPlayerControllerIterator Iterator = World.GetPlayerControllerIterator(); Iterator; ++Iterator)
-		{
-			APMPlayerController* PlayerController = static_cast<APMPlayerController*>(Iterator->Get());
-			DoThis(*PlayerController);
-		}
+		return;
 	}
+
+	ApplyMatchAction(*Match, Match->GetRules().SetReady(Player.GetMatchSlot(), Player.IsReady()));
 }
 
-void APMGameModeBase::Tick(float DeltaSeconds)
+void APMGameModeBase::HandlePlayerVote(const APMPlayerState& Player, const APMPlayerState* Suspect)
 {
-	const bool bServerTimerReached = GetPMGameState()->IsServerTimerActive() && (GetPMGameState()->GetServerTimerRemainingTime() == 0.f);
+	APMMatch* Match = Player.GetMatch();
+	if (!Match || (Suspect && (Suspect->GetMatch() != Match)))
+	{
+		return;
+	}
 
-	UWorld& World = *GetWorld();
-	
-	if (GetPMGameState()->InMatchState(EMatchState::WaitingToStart))
+	FPMMatchRules& Rules = Match->GetRules();
+	const EMatchAction Action = Rules.CastVote(Player.GetMatchSlot(), Suspect ? Suspect->GetMatchSlot() : INDEX_NONE);
+
+	// the ballot shows before a last vote closes the round and reveals them all
+	Match->GetVoteTracker()->SetVoted(Player.GetMatchSlot(), Rules.HasVoted(Player.GetMatchSlot()));
+
+	ApplyMatchAction(*Match, Action);
+}
+
+void APMGameModeBase::HandlePuppetChanged(const APMCharacter& Character)
+{
+	APMMatch* Match = Character.GetMatch();
+	if (!Match)
 	{
-		int32 NumReadyPlayers = 0;
-		bool bAllPlayersReady = true;
-		for (const APlayerState* Player : GetPMGameState()->PlayerArray)
+		return;
+	}
+
+	// the rules keep head counts, so this is cheap enough to ask on every change
+	ApplyMatchAction(*Match, Match->GetRules().CheckOutcome());
+}
+
+FPMMatchRulesConfig APMGameModeBase::GetRulesConfig() const
+{
+	FPMMatchRulesConfig Config;
+	Config.HealthMax = HealthMax;
+	Config.MinNumPlayers = MinNumPlayers;
+	Config.NumKillers = NumKillers;
+	Config.StartDelay = StartDelay;
+	Config.DiscussionLength = DiscussionLength;
+	Config.VotingLength = VotingLength;
+	Config.DeliberationLength = DeliberationLength;
+	Config.PostMatchLength = PostMatchLength;
+	return Config;
+}
+
+APlayerController* APMGameModeBase::SpawnPlayerController(ENetRole InRemoteRole, const FString& Options)
+{
+	if (UGameplayStatics::HasOption(Options, TEXT("PMBot")) && BotPlayerControllerClass)
+	{
+		TGuardValue<TSubclassOf<APlayerController>> BotClassGuard(PlayerControllerClass, BotPlayerControllerClass);
+		return Super::SpawnPlayerController(InRemoteRole, Options);
+	}
+
+	return Super::SpawnPlayerController(InRemoteRole, Options);
+}
+
+void APMGameModeBase::PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+
+	// a player coming back to their match needs no new room
+	const FString ReconnectToken = UGameplayStatics::ParseOption(Options, APMPlayerState::ReconnectTokenOption);
+	if (ErrorMessage.IsEmpty() && !HasRoomForNewPlayer() && !FindInactivePlayer(UniqueId, ReconnectToken))
+	{
+		ErrorMessage = TEXT("Server full.");
+	}
+}
+
+FString APMGameModeBase::InitNewPlayer(APlayerController* NewPlayerController, const FUniqueNetIdRepl& UniqueId, const FString& Options, const FString& Portal)
+{
+	const FString ErrorMessage = Super::InitNewPlayer(NewPlayerController, UniqueId, Options, Portal);
+
+	// only claimed so far, PostLogin either finds the kept player it belongs to or issues a new one
+	if (APMPlayerState* Player = NewPlayerController->GetPlayerState<APMPlayerState>())
+	{
+		Player->SetReconnectToken(UGameplayStatics::ParseOption(Options, APMPlayerState::ReconnectTokenOption));
+	}
+
+	return ErrorMessage;
+}
+
+void APMGameModeBase::PostLogin(APlayerController* NewPlayer)
+{
+	// back from a drop, the player picks up where they left rather than joining a new match
+	APMPlayerController* PMPlayerController = Cast<APMPlayerController>(NewPlayer);
+	APMPlayerState* Player = NewPlayer->GetPlayerState<APMPlayerState>();
+	APMPlayerState* InactivePlayer = PMPlayerController ? FindInactivePlayer(Player->GetUniqueId(), Player->GetReconnectToken()) : nullptr;
+	if (InactivePlayer)
+	{
+		ReconnectPlayer(*PMPlayerController, *InactivePlayer);
+		Super::PostLogin(NewPlayer);
+		return;
+	}
+
+	// the match has to be known before the player is started
+	APMMatch* Match = FindOrCreateMatchFor(*Player);
+	if (!Match || !Match->AddPlayer(*Player))
+	{
+		// the last room went to someone else between their PreLogin and ours
+		Super::PostLogin(NewPlayer);
+		GameSession->KickPlayer(NewPlayer, NSLOCTEXT("PuppetMaster", "ServerFull", "Server full."));
+		return;
+	}
+
+	// without an online id to know them by, a random token only they are sent is what they come back with
+	Player->SetReconnectToken(Player->GetUniqueId().IsValid() ? FString() : FGuid::NewGuid().ToString(EGuidFormats::Digits));
+	if (PMPlayerController && !Player->GetReconnectToken().IsEmpty())
+	{
+		PMPlayerController->ClientReconnectToken(Player->GetReconnectToken());
+	}
+
+	Super::PostLogin(NewPlayer);
+
+	// whoever joins isn't ready yet, so a running countdown has to wait for them
+	HandleMatchEvent(*Match, EMatchEvent::PlayersNotReady);
+}
+
+void APMGameModeBase::Logout(AController* Exiting)
+{
+	APMPlayerState* Player = Exiting->GetPlayerState<APMPlayerState>();
+	APMMatch* Match = Player ? Player->GetMatch() : nullptr;
+	if (Match && ShouldKeepInactivePlayer(*Player))
+	{
+		KeepInactivePlayer(*Player);
+	}
+	else if (Match)
+	{
+		// nobody looks for a puppet before the start, and its slot goes to whoever joins next
+		APMPlayerController* PlayerController = Cast<APMPlayerController>(Exiting);
+		if (PlayerController && PlayerController->GetSimulatedPawn() && Match->InMatchState(EMatchState::WaitingToStart))
 		{
-			if (static_cast<const APMPlayerState*>(Player)->IsReady())
-			{
-				NumReadyPlayers += 1;
-			}
-			else
-			{
-				bAllPlayersReady = false;
-				break;
-			}
+			GetWorld()->GetSubsystem<UPMCharacterPool>()->ReleaseCharacter(*static_cast<APMCharacter*>(PlayerController->GetSimulatedPawn()));
+			PlayerController->SetSimulatedPawn(nullptr);
 		}
 
-		const bool bReadyToStart = bAllPlayersReady && (NumReadyPlayers >= NumReadyPlayers);
-		if (bReadyToStart)
+		const EMatchAction Action = Match->RemovePlayer(*Player);
+
+		if (Match->GetNumPlayers() == 0)
 		{
-			if (!GetPMGameState()->IsServerTimerActive())
-			{
-				GetPMGameState()->StartServerTimer(StartDelay);
-			}
-			else if (bServerTimerReached)
-			{
-				ForEachPlayer
-				(
-					World,
-					[this](APMPlayerController& PlayerController)
-					{
-						if (PlayerCanRestart(&PlayerController))
-						{
-							RestartPlayer(&PlayerController);
-
-							if (IsValid(PlayerController.GetSimulatedPawn()))
-							{
-								PlayerController.GetPlayerState<APMPlayerState>()->SetStatus(EPlayerMatchStatus::Alive);
-							}
-						}
-					}
-				);
-
-				EnterInvestigationState();
-			}
+			DestroyMatch(*Match);
 		}
 		else
 		{
-			GetPMGameState()->ClearServerTimer();
+			ApplyMatchAction(*Match, Action);
 		}
 	}
-	else if (GetPMGameState()->InMatchState(EMatchState::Investigation))
+
+	Super::Logout(Exiting);
+}
+
+APMMatch* APMGameModeBase::FindOrCreateMatchFor(const APMPlayerState& Player)
+{
+	if (APMMatch* Match = FindMatchWithRoom())
 	{
+		return Match;
+	}
 
+	if (Matches.Num() < GetMaxMatches())
+	{
+		return CreateMatch();
 	}
-	else if (GetPMGameState()->InMatchState(EMatchState::Discussion))
+
+	UE_LOG(LogGameMode, Warning, TEXT("No match has room for %s"), *Player.GetPlayerName());
+	return nullptr;
+}
+
+APMMatch* APMGameModeBase::FindMatchWithRoom() const
+{
+	APMMatch* const* Match = Matches.FindByPredicate([this](const APMMatch* Candidate)
+	{
+		return Candidate->InMatchState(EMatchState::WaitingToStart) && (Candidate->GetNumPlayers() < FMath::Min(MaxPlayersPerMatch, FPMMatchRules::MaxSlots));
+	});
+
+	return Match ? *Match : nullptr;
+}
+
+bool APMGameModeBase::HasRoomForNewPlayer() const
+{
+	return (Matches.Num() < GetMaxMatches()) || (FindMatchWithRoom() != nullptr);
+}
+
+APMMatch* APMGameModeBase::CreateMatch()
+{
+	// reuse the slot of a finished match so instances stay packed
+	int32 MatchIndex = 0;
+	while (Matches.ContainsByPredicate([MatchIndex](const APMMatch* Match) { return Match->GetMatchIndex() == MatchIndex; }))
+	{
+		++MatchIndex;
+	}
+
+	APMMatch* Match = GetWorld()->SpawnActorDeferred<APMMatch>(APMMatch::StaticClass(), FTransform::Identity);
+	Match->InitMatch(MatchIndex, GetMatchOrigin(MatchIndex), MatchLevel, GetRulesConfig());
+	Match->FinishSpawning(FTransform::Identity);
+
+	Matches.Add(Match);
+	UpdateServerTickRate();
+
+	UE_LOG(LogGameMode, Log, TEXT("Opened match %d, %d running"), MatchIndex, Matches.Num());
+
+	return Match;
+}
+
+void APMGameModeBase::DestroyMatch(APMMatch& Match)
+{
+	ForgetInactivePlayers(Match);
+
+	// copied, pooled puppets take themselves out of the match
+	UPMCharacterPool* Pool = GetWorld()->GetSubsystem<UPMCharacterPool>();
+	const TArray<APMCharacter*> Characters = Match.GetCharacters();
+	for (APMCharacter* Character : Characters)
 	{
-		if (bServerTimerReached)
+		if (IsValid(Character))
 		{
-			EnterVotingState();
+			Pool->ReleaseCharacter(*Character);
 		}
 	}
-	else if (GetPMGameState()->InMatchState(EMatchState::Voting))
+
+	Matches.RemoveSingle(&Match);
+
+	UE_LOG(LogGameMode, Log, TEXT("Closed match %d, %d running"), Match.GetMatchIndex(), Matches.Num());
+
+	Match.Destroy();
+
+	UpdateServerTickRate();
+}
+
+FVector APMGameModeBase::GetMatchOrigin(int32 MatchIndex) const
+{
+	const FIntPoint Cell = GetSpiralCell(MatchIndex);
+	return FVector(Cell.X * MatchSpacing, Cell.Y * MatchSpacing, 0.f);
+}
+
+int32 APMGameModeBase::GetMaxMatches() const
+{
+	// without a level to instance every match would share the same map
+	if (MatchLevel.IsNull() || (MatchSpacing <= 0.f))
+	{
+		return 1;
+	}
+
+	// every match keeps half the spacing around its origin, which has to stay inside the world
+	const int32 MaxRing = FMath::Max(FMath::FloorToInt(static_cast<float>(HALF_WORLD_MAX) / MatchSpacing - 0.5f), 0);
+	return FMath::Clamp(MaxMatches, 1, FMath::Square(2 * MaxRing + 1));
+}
+
+void APMGameModeBase::HandleMatchEvent(APMMatch& Match, EMatchEvent Event)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMHandleMatchEvent);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, HandleMatchEvent);
+
+	UE_LOG(LogGameMode, Verbose, TEXT("Match %d: HandleMatchEvent %s in %s"), Match.GetMatchIndex(), LexToString(Event), *UEnum::GetValueAsString(Match.GetMatchState()));
+
+	ApplyMatchAction(Match, Match.GetRules().HandleEvent(Event));
+}
+
+void APMGameModeBase::ApplyMatchAction(APMMatch& Match, EMatchAction Action)
+{
+	struct FMatchActionHandler
+	{
+		EMatchAction Action;
+		void (APMGameModeBase::*Handler)(APMMatch& Match);
+	};
+
+	static const FMatchActionHandler Handlers[] =
 	{
-		int32 NumVotedPlayers = 0;
-		bool bAllPlayersVoted = true;
-		for (const APlayerState* Player : GetPMGameState()->PlayerArray)
+		{ EMatchAction::StartCountdown,			&APMGameModeBase::StartCountdown },
+		{ EMatchAction::CancelCountdown,		&APMGameModeBase::CancelCountdown },
+		{ EMatchAction::StartMatch,				&APMGameModeBase::StartMatch },
+		{ EMatchAction::EnterDiscussion,		&APMGameModeBase::EnterDiscussionState },
+		{ EMatchAction::EnterVoting,			&APMGameModeBase::EnterVotingState },
+		{ EMatchAction::EnterDeliberation,		&APMGameModeBase::EnterDeliberationState },
+		{ EMatchAction::ResumeInvestigation,	&APMGameModeBase::EnterInvestigationState },
+		{ EMatchAction::EndMatch,				&APMGameModeBase::EndMatch },
+		{ EMatchAction::ResetMatch,				&APMGameModeBase::ResetMatch },
+	};
+
+	for (const FMatchActionHandler& Handler : Handlers)
+	{
+		if (Handler.Action == Action)
 		{
-			if (static_cast<const APMPlayerState*>(Player)->IsReady())
-			{
-				NumVotedPlayers += 1;
-			}
-			else
+			// the rules have moved on already, clients follow
+			Match.SetMatchState(ToMatchState(Match.GetRules().GetState()));
+			(this->*Handler.Handler)(Match);
+			UpdateServerTickRate();
+			return;
+		}
+	}
+}
+
+void APMGameModeBase::StartMatchTimer(APMMatch& Match, float TimerLength)
+{
+	// the match only mirrors the timer so clients can display it
+	Match.StartServerTimer(TimerLength);
+	GetWorldTimerManager().SetTimer(Match.MatchTimerHandle, FTimerDelegate::CreateUObject(this, &APMGameModeBase::OnMatchTimerExpired, &Match), TimerLength, false);
+}
+
+void APMGameModeBase::ClearMatchTimer(APMMatch& Match)
+{
+	Match.ClearServerTimer();
+	GetWorldTimerManager().ClearTimer(Match.MatchTimerHandle);
+}
+
+void APMGameModeBase::OnMatchTimerExpired(APMMatch* Match)
+{
+	// the match clears its timer when it goes away, so it's still around here
+	check(IsValid(Match));
+
+	Match->ClearServerTimer();
+	HandleMatchEvent(*Match, EMatchEvent::TimerExpired);
+}
+
+void APMGameModeBase::StartCountdown(APMMatch& Match)
+{
+	StartMatchTimer(Match, Match.GetRules().GetTimerLength());
+}
+
+void APMGameModeBase::CancelCountdown(APMMatch& Match)
+{
+	ClearMatchTimer(Match);
+}
+
+void APMGameModeBase::StartMatch(APMMatch& Match)
+{
+	Match.ForEachPlayerController
+	(
+		[this](APMPlayerController& PlayerController)
+		{
+			if (PlayerCanRestart(&PlayerController))
 			{
-				bAllPlayersVoted = false;
-				break;
+				RestartPlayer(&PlayerController);
 			}
 		}
+	);
+
+	Match.SyncPlayers();
+	Match.MatchStartTime = GetWorld()->GetTimeSeconds();
+
+	EnterInvestigationState(Match);
+}
+
+void APMGameModeBase::EnterInvestigationState(APMMatch& Match)
+{
+	check(Match.InMatchState(EMatchState::Investigation));
 
-		if (bAllPlayersVoted || bServerTimerReached)
+	SetPuppetsFrozen(Match, false);
+
+	Match.ForEachPlayerController
+	(
+		[this](APMPlayerController& PlayerController)
 		{
-			EnterDeliberationState();
+			PlayerController.EnableInput(&PlayerController);
 		}
-	}
-	else if (GetPMGameState()->InMatchState(EMatchState::Deliberation))
-	{
-		if (bServerTimerReached)
+	);
+}
+
+void APMGameModeBase::EnterDiscussionState(APMMatch& Match)
+{
+	check(Match.InMatchState(EMatchState::Discussion));
+
+	StartMatchTimer(Match, Match.GetRules().GetTimerLength());
+
+	Match.ForEachPlayerController
+	(
+		[this](APMPlayerController& PlayerController)
 		{
-			EnterInvestigationState(); // #todo: see if the game is over
+			PlayerController.DisableInput(&PlayerController);
 		}
-	}
+	);
+
+	SetPuppetsFrozen(Match, true);
+}
+
+void APMGameModeBase::EnterVotingState(APMMatch& Match)
+{
+	check(Match.InMatchState(EMatchState::Voting));
 
-	if (bServerTimerReached)
+	Match.GetVoteTracker()->OpenVoting(Match.GetRules().GetNumSlots());
+
+	StartMatchTimer(Match, Match.GetRules().GetTimerLength());
+}
+
+void APMGameModeBase::EnterDeliberationState(APMMatch& Match)
+{
+	check(Match.InMatchState(EMatchState::Deliberation));
+
+	StartMatchTimer(Match, Match.GetRules().GetTimerLength());
+
+	Match.GetVoteTracker()->RevealVotes(Match.GetRules());
+
+	const int32 EjectedPlayer = Match.GetRules().GetEjectedPlayer();
+	if (EjectedPlayer != INDEX_NONE)
 	{
-		GetPMGameState()->ClearServerTimer();
+		for (APMCharacter* Character : Match.GetCharacters())
+		{
+			if (Character->GetMatchSlot() == EjectedPlayer)
+			{
+				Character->Eject();
+			}
+		}
+
+		Match.SyncPlayers();
 	}
+
+	SetPuppetsFrozen(Match, true);
 }
 
-void APMGameModeBase::EnterInvestigationState()
+void APMGameModeBase::EndMatch(APMMatch& Match)
 {
-	check(GetPMGameState()->InMatchState(EMatchState::WaitingToStart) || GetPMGameState()->InMatchState(EMatchState::Deliberation));
-	GetPMGameState()->SetMatchState(EMatchState::Investigation);
+	check(Match.InMatchState(EMatchState::PostMatch));
+
+	const FPMMatchRules& Rules = Match.GetRules();
+	UE_LOG(LogGameMode, Log, TEXT("Match %d: over, %s"), Match.GetMatchIndex(), *UEnum::GetValueAsString(ToMatchOutcome(Rules.GetOutcome())));
+
+	ClearMatchTimer(Match);
+	SetPuppetsFrozen(Match, true);
+
+	// the result shows for a while, then the match resets in place rather than travelling
+	if (Rules.GetTimerLength() > 0.f)
+	{
+		StartMatchTimer(Match, Rules.GetTimerLength());
+	}
 
-	ForEachPlayer
+	Match.ForEachPlayerController
 	(
-		*GetWorld(),
 		[this](APMPlayerController& PlayerController)
 		{
-			PlayerController.EnableInput(&PlayerController);
+			PlayerController.DisableInput(&PlayerController);
 		}
 	);
+
+	FPMMatchSummary Summary;
+	Summary.Outcome = ToMatchOutcome(Rules.GetOutcome());
+	Summary.Length = GetWorld()->GetTimeSeconds() - Match.MatchStartTime;
+	Summary.NumEjections = FMath::Min(Rules.GetNumEjections(), 255);
+	Summary.NumKills = FMath::Min(Rules.GetInnocentHeadCount().Dead + Rules.GetKillerHeadCount().Dead - Rules.GetNumEjections(), 255);
+
+	for (APMPlayerState* Player : Match.GetPlayers())
+	{
+		if (Rules.IsKiller(Player->GetMatchSlot()))
+		{
+			Summary.Killers.Add(Player);
+		}
+	}
+
+	Match.SendMatchSummary(Summary);
 }
 
-void APMGameModeBase::EnterDiscussionState()
+void APMGameModeBase::ResetMatch(APMMatch& Match)
 {
-	check(GetPMGameState()->InMatchState(EMatchState::Investigation));
-	GetPMGameState()->SetMatchState(EMatchState::Discussion);
+	check(Match.InMatchState(EMatchState::WaitingToStart));
 
-	GetPMGameState()->StartServerTimer(DiscussionLength);
+	SCOPE_CYCLE_COUNTER(STAT_PMResetMatch);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, ResetMatch);
+	const double StartTime = FPlatformTime::Seconds();
 
-	ForEachPlayer
+	ClearMatchTimer(Match);
+	ForgetInactivePlayers(Match);
+
+	// bodies and puppets alike, the players get theirs back from the pool below
+	UPMCharacterPool* Pool = GetWorld()->GetSubsystem<UPMCharacterPool>();
+	const TArray<APMCharacter*> Characters = Match.GetCharacters();
+	for (APMCharacter* Character : Characters)
+	{
+		if (IsValid(Character))
+		{
+			Pool->ReleaseCharacter(*Character);
+		}
+	}
+
+	// the rules forgot everyone, players who left don't keep their slots
+	Match.ResetPlayers();
+
+	Match.ForEachPlayerController
 	(
-		*GetWorld(),
 		[this](APMPlayerController& PlayerController)
 		{
-			PlayerController.DisableInput(&PlayerController);
+			PlayerController.SetSimulatedPawn(nullptr);
+			PlayerController.EnableInput(&PlayerController);
+
+			if (PlayerCanRestart(&PlayerController))
+			{
+				RestartPlayer(&PlayerController);
+			}
 		}
 	);
+
+	UE_LOG(LogGameMode, Log, TEXT("Match %d: reset for %d players in %.2f ms"), Match.GetMatchIndex(), Match.GetNumPlayers(), 1000.0 * (FPlatformTime::Seconds() - StartTime));
+}
+
+void APMGameModeBase::SetPuppetsFrozen(APMMatch& Match, bool bFrozen)
+{
+	// bodies included, nothing moves until investigation resumes
+	for (APMCharacter* Character : Match.GetCharacters())
+	{
+		Character->SetFrozen(bFrozen);
+	}
+}
+
+bool APMGameModeBase::ShouldKeepInactivePlayer(const APMPlayerState& Player) const
+{
+	// a waiting match simply gets them back as a new player, a finished one is about to reset
+	const APMMatch* Match = Player.GetMatch();
+	return (InactivePlayerTimeout > 0.f) && Match && !Match->InMatchState(EMatchState::WaitingToStart) && !Match->InMatchState(EMatchState::PostMatch);
+}
+
+void APMGameModeBase::KeepInactivePlayer(APMPlayerState& Player)
+{
+	APMMatch* Match = Player.GetMatch();
+	check(Match);
+
+	// the rules still count them in, their puppet stays where it is and can be found like any other
+	Player.SetStatus(EPlayerMatchStatus::Disconnected);
+	for (APMCharacter* Character : Match->GetCharacters())
+	{
+		if (Character->GetMatchSlot() == Player.GetMatchSlot())
+		{
+			Character->StopMoving();
+		}
+	}
+
+	InactivePlayers.Add(&Player);
+	INC_DWORD_STAT(STAT_PMInactivePlayers);
+	GetWorldTimerManager().SetTimer(Player.InactiveTimerHandle, FTimerDelegate::CreateUObject(this, &APMGameModeBase::OnInactivePlayerExpired, &Player), InactivePlayerTimeout, false);
+
+	UE_LOG(LogGameMode, Log, TEXT("Match %d: keeping %s for %.0fs"), Match->GetMatchIndex(), *Player.GetPlayerName(), InactivePlayerTimeout);
+}
+
+void APMGameModeBase::OnInactivePlayerExpired(APMPlayerState* Player)
+{
+	check(IsValid(Player));
+
+	InactivePlayers.RemoveSingleSwap(Player);
+	DEC_DWORD_STAT(STAT_PMInactivePlayers);
+
+	// now they leave for real, like Logout would have had them
+	if (APMMatch* Match = Player->GetMatch())
+	{
+		const EMatchAction Action = Match->RemovePlayer(*Player);
+
+		if (Match->GetNumPlayers() == 0)
+		{
+			DestroyMatch(*Match);
+		}
+		else
+		{
+			ApplyMatchAction(*Match, Action);
+		}
+	}
+
+	Player->Destroy();
+}
+
+void APMGameModeBase::ForgetInactivePlayers(APMMatch& Match)
+{
+	for (int32 Index = InactivePlayers.Num() - 1; Index >= 0; --Index)
+	{
+		APMPlayerState* Player = InactivePlayers[Index];
+		if (Player->GetMatch() != &Match)
+		{
+			continue;
+		}
+
+		InactivePlayers.RemoveAtSwap(Index);
+		DEC_DWORD_STAT(STAT_PMInactivePlayers);
+		GetWorldTimerManager().ClearTimer(Player->InactiveTimerHandle);
+
+		Match.DetachPlayer(*Player);
+		Player->Destroy();
+	}
+}
+
+APMPlayerState* APMGameModeBase::FindInactivePlayer(const FUniqueNetIdRepl& UniqueId, const FString& ReconnectToken) const
+{
+	// names are whatever the client says, only an id or the token it was sent proves who it is
+	for (APMPlayerState* Player : InactivePlayers)
+	{
+		const bool bSameId = UniqueId.IsValid() && (Player->GetUniqueId() == UniqueId);
+		const bool bSameToken = !ReconnectToken.IsEmpty() && Player->GetReconnectToken().Equals(ReconnectToken, ESearchCase::CaseSensitive);
+		if (bSameId || bSameToken)
+		{
+			return Player;
+		}
+	}
+
+	return nullptr;
 }
 
-void APMGameModeBase::EnterVotingState()
+void APMGameModeBase::ReconnectPlayer(APMPlayerController& NewPlayer, APMPlayerState& InactivePlayer)
 {
-	check(GetPMGameState()->InMatchState(EMatchState::Discussion));
-	GetPMGameState()->SetMatchState(EMatchState::Voting);
+	SCOPE_CYCLE_COUNTER(STAT_PMReconnectPlayer);
+	const double StartTime = FPlatformTime::Seconds();
+
+	InactivePlayers.RemoveSingleSwap(&InactivePlayer);
+	DEC_DWORD_STAT(STAT_PMInactivePlayers);
+	GetWorldTimerManager().ClearTimer(InactivePlayer.InactiveTimerHandle);
+
+	// the kept player state takes over from the one the login spawned, slot, status and all, but goes on with the
+	// login's unique id, name and player id
+	APlayerState* FreshPlayer = NewPlayer.PlayerState;
+	NewPlayer.PlayerState = &InactivePlayer;
+	InactivePlayer.SetOwner(&NewPlayer);
+	InactivePlayer.DispatchOverrideWith(FreshPlayer);
+
+	// the fresh one leaves quietly, without a goodbye message or unregistering the id the kept state now holds
+	FreshPlayer->SetIsInactive(true);
+	FreshPlayer->SetUniqueId(nullptr);
+	FreshPlayer->Destroy();
+	InactivePlayer.OnReactivated();
+	InactivePlayer.ForceNetUpdate();
+
+	APMMatch* Match = InactivePlayer.GetMatch();
+	check(Match);
+
+	InactivePlayer.SetStatus(ToPlayerMatchStatus(Match->GetRules().GetStatus(InactivePlayer.GetMatchSlot())));
+
+	APMCharacter* Puppet = nullptr;
+	for (APMCharacter* Character : Match->GetCharacters())
+	{
+		if (Character->GetMatchSlot() == InactivePlayer.GetMatchSlot())
+		{
+			Puppet = Character;
+		}
+	}
 
-	GetPMGameState()->StartServerTimer(VotingLength);
+	NewPlayer.SetSimulatedPawn(Puppet);
+
+	// the puppet and the match go out with the first updates rather than whenever they're next due
+	if (Puppet)
+	{
+		Puppet->FlushNetDormancy();
+		Puppet->ForceNetUpdate();
+	}
+	Match->ForceNetUpdate();
+
+	if (!Match->InMatchState(EMatchState::Investigation))
+	{
+		NewPlayer.DisableInput(&NewPlayer);
+	}
+
+	NewPlayer.ClientMatchSnapshot(Match->MakeSnapshot());
+
+	UE_LOG(LogGameMode, Log, TEXT("Match %d: %s reconnected in %.2f ms"), Match->GetMatchIndex(), *InactivePlayer.GetPlayerName(), 1000.0 * (FPlatformTime::Seconds() - StartTime));
 }
 
-void APMGameModeBase::EnterDeliberationState()
+void APMGameModeBase::UpdateServerTickRate()
 {
-	check(GetPMGameState()->InMatchState(EMatchState::Voting));
-	GetPMGameState()->SetMatchState(EMatchState::Deliberation);
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver)
+	{
+		return;
+	}
+
+	if (ActiveServerTickRate <= 0)
+	{
+		ActiveServerTickRate = NetDriver->NetServerMaxTickRate;
+	}
 
-	GetPMGameState()->StartServerTimer(DeliberationLength);
+	const bool bAnyInvestigating = Matches.ContainsByPredicate([](const APMMatch* Match) { return Match->InMatchState(EMatchState::Investigation); });
+	const int32 TickRate = bAnyInvestigating ? ActiveServerTickRate : FMath::Min(IdleServerTickRate, ActiveServerTickRate);
+	if (NetDriver->NetServerMaxTickRate != TickRate)
+	{
+		UE_LOG(LogGameMode, Verbose, TEXT("Server tick rate %d"), TickRate);
+		NetDriver->NetServerMaxTickRate = TickRate;
+	}
 }
 
-void APMGameModeBase::ReportBody(const APMCharacter& ReportingCharacter, const APMCharacter& DeadCharacter)
+bool APMGameModeBase::ReportBody(const APMCharacter& ReportingCharacter, const APMCharacter& DeadCharacter)
 {
-	check(GetPMGameState()->InMatchState(EMatchState::Investigation));
+	APMMatch* Match = ReportingCharacter.GetMatch();
+	check(Match && Match->InMatchState(EMatchState::Investigation));
+
+	const UPMProximitySubsystem* Proximity = GetWorld()->GetSubsystem<UPMProximitySubsystem>();
+	if (DeadCharacter.IsAlive())
+	{
+		UE_LOG(LogGameMode, Warning, TEXT("Match %d: %s reported %s, who is alive"), Match->GetMatchIndex(), *ReportingCharacter.GetName(), *DeadCharacter.GetName());
+		return false;
+	}
+
+	if (!Proximity->IsInInteractionRange(ReportingCharacter, DeadCharacter))
+	{
+		UE_LOG(LogGameMode, Warning, TEXT("Match %d: %s reported %s from out of range"), Match->GetMatchIndex(), *ReportingCharacter.GetName(), *DeadCharacter.GetName());
+		return false;
+	}
 
 	// #todo: broadcast report message
 
-	EnterDeliberationState();
+	HandleMatchEvent(*Match, EMatchEvent::BodyReported);
+	return true;
+}
+
+bool APMGameModeBase::ReportNearestBody(const APMCharacter& ReportingCharacter)
+{
+	const APMCharacter* Body = GetWorld()->GetSubsystem<UPMProximitySubsystem>()->FindNearestBody(ReportingCharacter);
+	return Body && ReportBody(ReportingCharacter, *Body);
 }
 
 void APMGameModeBase::CallMeeting(const APMCharacter& ReportingCharacter)
 {
-	check(GetPMGameState()->InMatchState(EMatchState::Investigation));
+	APMMatch* Match = ReportingCharacter.GetMatch();
+	check(Match && Match->InMatchState(EMatchState::Investigation));
 
 	// #todo: broadcast meeting message
 
-	EnterDiscussionState();
+	HandleMatchEvent(*Match, EMatchEvent::MeetingCalled);
 }
 
 void APMGameModeBase::HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer)
 {
-	// only start players if the match is waiting to start
-	if (GetPMGameState()->InMatchState(EMatchState::WaitingToStart) && PlayerCanRestart(NewPlayer))
+	// only start players if their match is waiting to start
+	const APMMatch* Match = NewPlayer->GetPlayerState<APMPlayerState>()->GetMatch();
+	if (Match && Match->InMatchState(EMatchState::WaitingToStart) && PlayerCanRestart(NewPlayer))
 	{
 		RestartPlayer(NewPlayer);
 	}
 }
 
+AActor* APMGameModeBase::ChoosePlayerStart_Implementation(AController* Player)
+{
+	const APMPlayerState* PlayerState = Player ? Player->GetPlayerState<APMPlayerState>() : nullptr;
+	const APMMatch* Match = PlayerState ? PlayerState->GetMatch() : nullptr;
+	const ULevel* MatchLevelInstance = Match ? Match->GetLoadedLevel() : nullptr;
+	if (!MatchLevelInstance)
+	{
+		return Super::ChoosePlayerStart_Implementation(Player);
+	}
+
+	TArray<APlayerStart*, TInlineAllocator<16>> Starts;
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		if (It->GetLevel() == MatchLevelInstance)
+		{
+			Starts.Add(*It);
+		}
+	}
+
+	if (Starts.Num() == 0)
+	{
+		return Super::ChoosePlayerStart_Implementation(Player);
+	}
+
+	// spread players over the starts in join order
+	const int32 PlayerIndex = FMath::Max(Match->GetPlayers().IndexOfByKey(PlayerState), 0);
+	return Starts[PlayerIndex % Starts.Num()];
+}
+
 void APMGameModeBase::RestartPlayerAtPlayerStart(AController* NewPlayer, AActor* StartSpot)
 {
 	if (NewPlayer == nullptr || NewPlayer->IsPendingKillPending())
@@ -256,16 +869,25 @@ void APMGameModeBase::RestartPlayerAtPlayerStart(AController* NewPlayer, AActor*
 		return;
 	}
 
+	UPMCharacterPool* Pool = GetWorld()->GetSubsystem<UPMCharacterPool>();
 	if (RecastNewPlayer->GetSimulatedPawn() != nullptr)
 	{
-		RecastNewPlayer->GetSimulatedPawn()->Destroy();
+		Pool->ReleaseCharacter(*static_cast<APMCharacter*>(RecastNewPlayer->GetSimulatedPawn()));
 		RecastNewPlayer->SetSimulatedPawn(nullptr);
 	}
 
-	if (GetDefaultPawnClassForController(RecastNewPlayer) != nullptr)
+	if (UClass* PawnClass = GetDefaultPawnClassForController(RecastNewPlayer))
 	{
-		// Try to create a pawn to use of the default class for this player
-		RecastNewPlayer->SetSimulatedPawn(SpawnDefaultPawnFor(RecastNewPlayer, StartSpot));
+		// reuse a pooled puppet where we can, spawning a whole lobby at once hitches
+		const FTransform SpawnTransform(FRotator(0.f, SpawnRotation.Yaw, 0.f), StartSpot->GetActorLocation());
+		APawn* Pawn = Pool->AcquireCharacter(PawnClass, SpawnTransform);
+		RecastNewPlayer->SetSimulatedPawn(Pawn ? Pawn : SpawnDefaultPawnFor(RecastNewPlayer, StartSpot));
+	}
+
+	APMMatch* Match = RecastNewPlayer->GetPlayerState<APMPlayerState>()->GetMatch();
+	if (Match && RecastNewPlayer->GetSimulatedPawn())
+	{
+		Match->AddCharacter(*static_cast<APMCharacter*>(RecastNewPlayer->GetSimulatedPawn()), RecastNewPlayer->GetPlayerState<APMPlayerState>()->GetMatchSlot());
 	}
 
 	if (RecastNewPlayer->GetSimulatedPawn() == nullptr)
@@ -281,15 +903,6 @@ void APMGameModeBase::RestartPlayerAtPlayerStart(AController* NewPlayer, AActor*
 
 
 
-void APMGameState::SetMatchState(EMatchState State)
-{
-	if (MatchState != State)
-	{
-		PrevMatchState = MatchState;
-		MatchState = State;
-	}
-}
-
 bool APMGameState::IsServerTimerActive() const
 {
 	return ServerTimerEnd != 0.f;
@@ -300,20 +913,24 @@ float APMGameState::GetServerTimerRemainingTime() const
 	return FMath::Max(0.f, ServerTimerEnd - GetServerWorldTimeSeconds());
 }
 
-void APMGameState::StartServerTimer(float TimerLength)
-{
-	ServerTimerEnd = GetServerWorldTimeSeconds() + TimerLength;
-}
-
-void APMGameState::ClearServerTimer()
+void APMGameState::ShowMatch(const APMMatch& Match)
 {
-	ServerTimerEnd = 0.f;
+	MatchState = Match.GetMatchState();
+	PrevMatchState = Match.GetPrevMatchState();
+	ServerTimerEnd = Match.GetServerTimerEnd();
+	MatchSummary = Match.GetMatchSummary();
+	VoteTracker = Match.GetVoteTracker();
 }
 
-void APMGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+void APMGameState::ShowSnapshot(const FPMMatchSnapshot& Snapshot)
 {
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	MatchSnapshot = Snapshot;
 
-	DOREPLIFETIME(APMGameState, ServerTimerEnd);
-	DOREPLIFETIME(APMGameState, MatchState);
+	// the match will catch up on the rest once it has replicated
+	if (MatchState != Snapshot.MatchState)
+	{
+		PrevMatchState = MatchState;
+		MatchState = Snapshot.MatchState;
+	}
+	ServerTimerEnd = Snapshot.ServerTimerEnd;
 }
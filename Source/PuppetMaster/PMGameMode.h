@@ -2,24 +2,23 @@
 
 #pragma once
 
+#include "PMMatchRules.h"
+#include "PMMatchTypes.h"
+
 #include "GameFramework/GameModeBase.h"
 #include "GameFramework/GameStateBase.h"
 
 #include "PMGameMode.generated.h"
 
 class APMCharacter;
-
-UENUM(BlueprintType)
-enum class EMatchState : uint8
-{
-	WaitingToStart,
-	Investigation,
-	Discussion,
-	Voting,
-	Deliberation,
-	PostMatch
-};
-
+class APMMatch;
+class APMPlayerController;
+class APMPlayerState;
+
+/**
+ * Hosts any number of matches side by side in one world. Each APMMatch runs its own state machine, players
+ * are put in the first match still waiting for players, and a new match is opened when none has room.
+ */
 UCLASS(minimalapi)
 class APMGameModeBase : public AGameModeBase
 {
@@ -29,6 +28,18 @@ public:
 
 	APMGameModeBase();
 
+	/** Called by player states on the server so readiness is counted as it changes rather than polled. */
+	void HandlePlayerReadyChanged(const APMPlayerState& Player);
+
+	/** Suspect is null to skip. */
+	void HandlePlayerVote(const APMPlayerState& Player, const APMPlayerState* Suspect);
+
+	/** Called by puppets on the server when they drop or get back up, the match may be decided. */
+	void HandlePuppetChanged(const APMCharacter& Character);
+
+	/** The configured tunables every new match plays by. */
+	FPMMatchRulesConfig GetRulesConfig() const;
+
 protected:
 
 	class APMGameState* GetPMGameState() const;
@@ -36,17 +47,79 @@ protected:
 	void InitGameState() override;
 	void StartPlay() override;
 
-	void Tick(float DeltaSeconds) override;
+	/** Clients joining with the PMBot url option get BotPlayerControllerClass, see APMBotPlayerController. */
+	APlayerController* SpawnPlayerController(ENetRole InRemoteRole, const FString& Options) override;
+
+	/** Turns players away while every match is full or running, rather than squeezing them into one. */
+	void PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
+	FString InitNewPlayer(APlayerController* NewPlayerController, const FUniqueNetIdRepl& UniqueId, const FString& Options, const FString& Portal) override;
+	void PostLogin(APlayerController* NewPlayer) override;
+	void Logout(AController* Exiting) override;
+
+	/** The match waiting for players with room left, opening a new one if there is none. Null once the server is full. */
+	APMMatch* FindOrCreateMatchFor(const APMPlayerState& Player);
+	APMMatch* FindMatchWithRoom() const;
+	bool HasRoomForNewPlayer() const;
+
+	APMMatch* CreateMatch();
+	void DestroyMatch(APMMatch& Match);
+
+	/** Matches are laid out on a square spiral around the world origin, MatchSpacing apart, see GetMatchOrigin. */
+	FVector GetMatchOrigin(int32 MatchIndex) const;
 
-	void EnterInvestigationState();
-	void EnterDiscussionState();
-	void EnterVotingState();
-	void EnterDeliberationState();
+	/** MaxMatches, less however many wouldn't fit inside the world bounds at MatchSpacing. */
+	int32 GetMaxMatches() const;
 
-	void ReportBody(const APMCharacter& ReportingCharacter, const APMCharacter& DeadCharacter);
+	/** Feeds the event to the match's rules and carries out whatever they decide. */
+	void HandleMatchEvent(APMMatch& Match, EMatchEvent Event);
+	void ApplyMatchAction(APMMatch& Match, EMatchAction Action);
+
+	void StartMatchTimer(APMMatch& Match, float TimerLength);
+	void ClearMatchTimer(APMMatch& Match);
+	void OnMatchTimerExpired(APMMatch* Match);
+
+	void StartCountdown(APMMatch& Match);
+	void CancelCountdown(APMMatch& Match);
+	void StartMatch(APMMatch& Match);
+
+	void EnterInvestigationState(APMMatch& Match);
+	void EnterDiscussionState(APMMatch& Match);
+	void EnterVotingState(APMMatch& Match);
+	void EnterDeliberationState(APMMatch& Match);
+	void EndMatch(APMMatch& Match);
+
+	/** Gets the match ready for the next one in the same world, with the players it still has. */
+	void ResetMatch(APMMatch& Match);
+
+	void SetPuppetsFrozen(APMMatch& Match, bool bFrozen);
+
+	/** A player who drops out of a running match keeps their slot and puppet for InactivePlayerTimeout. */
+	bool ShouldKeepInactivePlayer(const APMPlayerState& Player) const;
+	void KeepInactivePlayer(APMPlayerState& Player);
+	void OnInactivePlayerExpired(APMPlayerState* Player);
+
+	/** Drops the kept players of a match that is reset or closed, their slots are gone. */
+	void ForgetInactivePlayers(APMMatch& Match);
+
+	/** The kept player a login with UniqueId, or without one ReconnectToken, comes back as, if any. Never goes by name. */
+	APMPlayerState* FindInactivePlayer(const FUniqueNetIdRepl& UniqueId, const FString& ReconnectToken) const;
+
+	/**
+	 * Hands the kept player state, slot and puppet back to the new controller and sends it the match in one go. The kept
+	 * state takes over the fresh one's unique id, name and player id the way AGameMode::FindInactivePlayer does.
+	 */
+	void ReconnectPlayer(APMPlayerController& NewPlayer, APMPlayerState& InactivePlayer);
+
+	/** Only investigation needs the full tick rate, the server idles while no match is in it. */
+	void UpdateServerTickRate();
+
+	/** Only bodies within interaction range of the reporter can be reported. Returns true if the report was taken. */
+	bool ReportBody(const APMCharacter& ReportingCharacter, const APMCharacter& DeadCharacter);
+	bool ReportNearestBody(const APMCharacter& ReportingCharacter);
 	void CallMeeting(const APMCharacter& ReportingCharacter);
 
 	void HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer) override;
+	AActor* ChoosePlayerStart_Implementation(AController* Player) override;
 	void RestartPlayerAtPlayerStart(AController* NewPlayer, AActor* StartSpot) override;
 
 protected:
@@ -54,6 +127,12 @@ protected:
 	UPROPERTY(config)
 	int32 MinNumPlayers = 2;
 
+	UPROPERTY(config)
+	int32 NumKillers = 1;
+
+	UPROPERTY(config)
+	int32 HealthMax = 2;
+
 	UPROPERTY(config)
 	float StartDelay = 3.f;
 
@@ -66,8 +145,49 @@ protected:
 	UPROPERTY(config)
 	float DeliberationLength = 10.f;
 
+	UPROPERTY(config)
+	float PostMatchLength = 15.f;
+
+	UPROPERTY(config)
+	TSubclassOf<APlayerController> BotPlayerControllerClass;
+
+	/** Level every match gets its own instance of. Without one there is a single match in the persistent level. */
+	UPROPERTY(config)
+	TSoftObjectPtr<UWorld> MatchLevel;
+
+	UPROPERTY(config)
+	int32 MaxMatches = 16;
+
+	UPROPERTY(config)
+	int32 MaxPlayersPerMatch = 10;
+
+	/** Distance between match level instances, keep it above the size of the match level. */
+	UPROPERTY(config)
+	float MatchSpacing = 100000.f;
+
+	/** Dedicated server tick rate while no match is investigating, when nothing moves and only timers and votes change. */
+	UPROPERTY(config)
+	int32 IdleServerTickRate = 10;
+
+	/** How long a player who dropped mid-match can come back to their puppet, zero to drop them right away. */
+	UPROPERTY(config)
+	float InactivePlayerTimeout = 60.f;
+
+private:
+
+	UPROPERTY(Transient)
+	TArray<APMMatch*> Matches;
+
+	/** Player states of players who dropped out of a running match, kept for them to come back to. */
+	UPROPERTY(Transient)
+	TArray<APMPlayerState*> InactivePlayers;
+
+	/** The net driver's configured tick rate, restored once a match investigates again. */
+	int32 ActiveServerTickRate = 0;
+
 };
 
+/** Clients see the game state as the match their player is in, so UI doesn't need to know about APMMatch. */
 UCLASS(minimalAPI)
 class APMGameState : public AGameStateBase
 {
@@ -76,16 +196,15 @@ class APMGameState : public AGameStateBase
 public:
 
 	/** The time at which the server's current timer will end. */
-	UPROPERTY(Replicated, BlueprintReadOnly)
+	UPROPERTY(BlueprintReadOnly)
 	float ServerTimerEnd = 0.f;
 
-	UPROPERTY(Replicated, BlueprintReadOnly)
+	UPROPERTY(BlueprintReadOnly)
 	EMatchState MatchState = EMatchState::WaitingToStart;
 
 	EMatchState PrevMatchState = EMatchState::PostMatch;
 
 	bool InMatchState(EMatchState State) const { return State == MatchState; }
-	void SetMatchState(EMatchState State);
 
 	UFUNCTION(BlueprintPure)
 	bool IsServerTimerActive() const;
@@ -93,10 +212,22 @@ public:
 	UFUNCTION(BlueprintPure)
 	float GetServerTimerRemainingTime() const;
 
-	void StartServerTimer(float TimerLength);
-	void ClearServerTimer();
+	/** Ballots of the local player's match. */
+	UPROPERTY(BlueprintReadOnly)
+	class UPMVoteTracker* VoteTracker = nullptr;
 
-	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const;
+	/** How the local player's last match went, valid in PostMatch. */
+	UPROPERTY(BlueprintReadOnly)
+	FPMMatchSummary MatchSummary;
 
-};
+	/** Statuses and ballots of the local player's match as of their last reconnect, see FPMMatchSnapshot. */
+	UPROPERTY(BlueprintReadOnly)
+	FPMMatchSnapshot MatchSnapshot;
 
+	/** Mirrors the local player's match. */
+	void ShowMatch(const APMMatch& Match);
+
+	/** Stands in for the match until it has replicated again after a reconnect. */
+	void ShowSnapshot(const FPMMatchSnapshot& Snapshot);
+
+};
@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMLineOfSightComponent.h"
+
+#include "PMFogOfWarSubsystem.h"
+#include "PMOccluderSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+UPMLineOfSightComponent::UPMLineOfSightComponent()
+{
+	// only the puppet being viewed needs to see, see EnableVisualization
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UPMLineOfSightComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (NeedsRebuild())
+	{
+		GenerateLoSPoints();
+	}
+}
+
+void UPMLineOfSightComponent::RetrieveVisionParameters(float& OutVisionRadius, float& OutVisionAngle, FVector& OutForwardVector) const
+{
+	OutVisionRadius = VisionRadius;
+	OutVisionAngle = VisionAngle;
+	OutForwardVector = GetOwner()->GetActorForwardVector();
+}
+
+FVector UPMLineOfSightComponent::GetLoSLocation() const
+{
+	return GetOwner()->GetActorLocation();
+}
+
+void UPMLineOfSightComponent::GenerateLoSPoints()
+{
+	UPMOccluderSubsystem* Occluders = GetWorld()->GetSubsystem<UPMOccluderSubsystem>();
+	check(Occluders);
+
+	const FVector Origin = GetLoSLocation();
+	const float Yaw = GetOwner()->GetActorRotation().Yaw;
+
+	Occluders->GatherSegments(Origin, VisionRadius, SegmentScratch);
+
+	const float Span = FMath::DegreesToRadians(VisionAngle);
+	const float StartAngle = FMath::DegreesToRadians(Yaw) - 0.5f * Span;
+	PMVisibility::ComputeVisibilityPolygon(FVector2D(Origin), VisionRadius, StartAngle, Span, SegmentScratch, PolygonScratch);
+
+	LoSPoints.Reset(PolygonScratch.Num());
+	for (const FVector2D& Point : PolygonScratch)
+	{
+		LoSPoints.Emplace(Point.X, Point.Y, Origin.Z);
+	}
+
+	// only the local player's puppet looks around, see EnableVisualization
+	if (UPMFogOfWarSubsystem* FogOfWar = GetWorld()->GetSubsystem<UPMFogOfWarSubsystem>())
+	{
+		FogOfWar->UpdateVisibility(PolygonScratch);
+	}
+
+	SegmentCount = SegmentScratch.Num();
+	VertexCount = LoSPoints.Num();
+
+	LastOrigin = Origin;
+	LastYaw = Yaw;
+	bHasLoS = true;
+
+	OnLoSUpdated.Broadcast();
+}
+
+void UPMLineOfSightComponent::EnableVisualization()
+{
+	bHasLoS = false;
+	SetComponentTickEnabled(true);
+}
+
+void UPMLineOfSightComponent::DisableVisualization()
+{
+	SetComponentTickEnabled(false);
+	LoSPoints.Reset();
+	OnLoSUpdated.Broadcast();
+}
+
+bool UPMLineOfSightComponent::NeedsRebuild() const
+{
+	if (!bHasLoS)
+	{
+		return true;
+	}
+
+	if (FVector::DistSquared2D(LastOrigin, GetLoSLocation()) > FMath::Square(RebuildDistanceThreshold))
+	{
+		return true;
+	}
+
+	// the yaw only matters when vision is a cone
+	return (VisionAngle < 360.f) && !FMath::IsNearlyEqual(LastYaw, GetOwner()->GetActorRotation().Yaw, 0.5f);
+}
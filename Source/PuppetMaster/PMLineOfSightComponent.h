@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMVisibility.h"
+
+#include "Components/ActorComponent.h"
+
+#include "PMLineOfSightComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FLoSUpdated);
+
+/**
+ * Native replacement for BPC_LoSVisualizer. Instead of fanning out line traces every frame, the visibility polygon
+ * is built from one angular sweep over the cached wall segments of UPMOccluderSubsystem.
+ */
+UCLASS(ClassGroup = PuppetMaster, meta = (BlueprintSpawnableComponent))
+class UPMLineOfSightComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UPMLineOfSightComponent();
+
+	void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Same outputs as BPI_LoSVisualization::RetrieveVisionParameters. */
+	UFUNCTION(BlueprintPure, Category = LineOfSight)
+	void RetrieveVisionParameters(float& OutVisionRadius, float& OutVisionAngle, FVector& OutForwardVector) const;
+
+	UFUNCTION(BlueprintPure, Category = LineOfSight)
+	FVector GetLoSLocation() const;
+
+	/** Visible area outline, counter clockwise. Narrower than full circle vision starts with the LoS location. */
+	UFUNCTION(BlueprintPure, Category = LineOfSight)
+	const TArray<FVector>& GetLoSPoints() const { return LoSPoints; }
+
+	/** Rebuilds the LoS points right away instead of waiting for the next tick. */
+	UFUNCTION(BlueprintCallable, Category = LineOfSight)
+	void GenerateLoSPoints();
+
+	UFUNCTION(BlueprintCallable, Category = LineOfSight)
+	void EnableVisualization();
+
+	UFUNCTION(BlueprintCallable, Category = LineOfSight)
+	void DisableVisualization();
+
+	UPROPERTY(BlueprintAssignable)
+	FLoSUpdated OnLoSUpdated;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = LineOfSight)
+	float VisionRadius = 1500.f;
+
+	/** Full cone angle in degrees, centered on the owner's forward vector. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = LineOfSight, meta = (ClampMin = "0.0", ClampMax = "360.0"))
+	float VisionAngle = 360.f;
+
+	/** Owner movement below this distance doesn't rebuild the polygon. */
+	UPROPERTY(EditAnywhere, Category = LineOfSight)
+	float RebuildDistanceThreshold = 1.f;
+
+	/** Same counters BPI_Profiling::DisplayProfilingData reports for the Blueprint visualizer. */
+	UPROPERTY(BlueprintReadOnly, Category = Profiling)
+	int32 SegmentCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Profiling)
+	int32 VertexCount = 0;
+
+private:
+
+	bool NeedsRebuild() const;
+
+	UPROPERTY(Transient)
+	TArray<FVector> LoSPoints;
+
+	TArray<FPMWallSegment> SegmentScratch;
+	TArray<FVector2D> PolygonScratch;
+
+	FVector LastOrigin = FVector::ZeroVector;
+	float LastYaw = 0.f;
+	bool bHasLoS = false;
+
+};
@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMLoadTestStats.h"
+
+#include "PMMatch.h"
+#include "PMPlayerController.h"
+#include "PuppetMaster.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+void UPMLoadTestStats::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FString CsvPath;
+	if (GetWorld()->IsGameWorld() && FParse::Value(FCommandLine::Get(), TEXT("PMStatsCsv="), CsvPath))
+	{
+		Writer = IFileManager::Get().CreateFileWriter(*CsvPath);
+		if (Writer)
+		{
+			UE_LOG(LogPuppetMaster, Log, TEXT("Writing load test stats to %s"), *CsvPath);
+
+			FTCHARToUTF8 Header(TEXT("Time,FrameMsAvg,FrameMsMax,BusyMsPerSec,TickRate,Connections,Player,MatchState,InBytesPerSec,OutBytesPerSec,ServerRPCs\n"));
+			Writer->Serialize(const_cast<ANSICHAR*>(Header.Get()), Header.Length());
+		}
+		else
+		{
+			UE_LOG(LogPuppetMaster, Error, TEXT("Could not open %s for load test stats"), *CsvPath);
+		}
+	}
+}
+
+void UPMLoadTestStats::Deinitialize()
+{
+	if (Writer)
+	{
+		Writer->Close();
+		delete Writer;
+		Writer = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+void UPMLoadTestStats::Tick(float DeltaTime)
+{
+	NumFrames += 1;
+	MaxFrameTime = FMath::Max(MaxFrameTime, DeltaTime);
+
+	// frames are mostly sleep once the tick rate drops, this is what they actually cost
+	BusyTime += FMath::Max(DeltaTime - static_cast<float>(FApp::GetIdleTime()), 0.f);
+	SampleTime += DeltaTime;
+	TotalTime += DeltaTime;
+
+	if (SampleTime >= SampleInterval)
+	{
+		WriteSample();
+
+		SampleTime = 0.f;
+		NumFrames = 0;
+		MaxFrameTime = 0.f;
+		BusyTime = 0.f;
+	}
+}
+
+TStatId UPMLoadTestStats::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPMLoadTestStats, STATGROUP_Tickables);
+}
+
+void UPMLoadTestStats::WriteSample()
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver || !NetDriver->IsServer())
+	{
+		return;
+	}
+
+	const float FrameMsAvg = 1000.f * SampleTime / FMath::Max(NumFrames, 1);
+	const float FrameMsMax = 1000.f * MaxFrameTime;
+	const float BusyMsPerSec = 1000.f * BusyTime / FMath::Max(SampleTime, KINDA_SMALL_NUMBER);
+
+	FString Rows;
+	for (const UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		APMPlayerController* PlayerController = Cast<APMPlayerController>(Connection->PlayerController);
+		const FString PlayerName = (PlayerController && PlayerController->PlayerState) ? PlayerController->PlayerState->GetPlayerName() : Connection->LowLevelGetRemoteAddress();
+
+		int32 ServerRPCs = 0;
+		if (PlayerController)
+		{
+			int32& LastCount = LastServerRPCCounts.FindOrAdd(PlayerController);
+			ServerRPCs = PlayerController->GetNumServerRPCs() - LastCount;
+			LastCount = PlayerController->GetNumServerRPCs();
+		}
+
+		// rows grouped by match state give the cost of each phase
+		const APMPlayerState* PlayerState = PlayerController ? PlayerController->GetPlayerState<APMPlayerState>() : nullptr;
+		const APMMatch* Match = PlayerState ? PlayerState->GetMatch() : nullptr;
+		const FString MatchState = Match ? UEnum::GetValueAsString(Match->GetMatchState()) : TEXT("None");
+
+		Rows += FString::Printf(TEXT("%.2f,%.3f,%.3f,%.1f,%d,%d,%s,%s,%d,%d,%d\n"), TotalTime, FrameMsAvg, FrameMsMax, BusyMsPerSec, NetDriver->NetServerMaxTickRate, NetDriver->ClientConnections.Num(), *PlayerName, *MatchState, Connection->InBytesPerSecond, Connection->OutBytesPerSecond, ServerRPCs);
+	}
+
+	// players that left don't need their counts anymore
+	for (auto It = LastServerRPCCounts.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (Rows.Len() > 0)
+	{
+		FTCHARToUTF8 Utf8Rows(*Rows);
+		Writer->Serialize(const_cast<ANSICHAR*>(Utf8Rows.Get()), Utf8Rows.Length());
+		Writer->Flush();
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "PMLoadTestStats.generated.h"
+
+/**
+ * Server side capacity numbers for load test runs with APMBotPlayerController clients.
+ * Started with -PMStatsCsv=<file>, every SampleInterval it writes one row per connection with the server frame
+ * time and busy time over the interval, the server tick rate, the state of the player's match, the connection's net
+ * bytes in and out per second and the server RPCs it sent.
+ */
+UCLASS(config = Game)
+class UPMLoadTestStats : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void Initialize(FSubsystemCollectionBase& Collection) override;
+	void Deinitialize() override;
+
+	// Begin FTickableGameObject interface
+	void Tick(float DeltaTime) override;
+	bool IsTickable() const override { return Writer != nullptr; }
+	TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+private:
+
+	void WriteSample();
+
+	FArchive* Writer = nullptr;
+
+	UPROPERTY(config)
+	float SampleInterval = 1.f;
+
+	float SampleTime = 0.f;
+	float TotalTime = 0.f;
+
+	int32 NumFrames = 0;
+	float MaxFrameTime = 0.f;
+
+	/** Frame time minus what was spent waiting for the next tick. */
+	float BusyTime = 0.f;
+
+	/** Server RPC totals per player controller at the last sample, so rows hold what came in since. */
+	TMap<TWeakObjectPtr<class APMPlayerController>, int32> LastServerRPCCounts;
+
+};
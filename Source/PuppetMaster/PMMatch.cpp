@@ -0,0 +1,390 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMMatch.h"
+
+#include "PMCharacter.h"
+#include "PMFogOfWarSubsystem.h"
+#include "PMOccluderSubsystem.h"
+#include "PMPlayerController.h"
+#include "PMVoteTracker.h"
+#include "PuppetMaster.h"
+
+#include "Engine/Engine.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+
+bool FPMMatchSnapshot::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	static_assert(static_cast<uint8>(EMatchState::PostMatch) < 8, "EMatchState no longer fits in 3 bits");
+	static_assert(static_cast<uint8>(EPlayerMatchStatus::Disconnected) < 8, "EPlayerMatchStatus no longer fits in 3 bits");
+
+	uint8 PackedState = static_cast<uint8>(MatchState);
+	Ar.SerializeBits(&PackedState, 3);
+	MatchState = static_cast<EMatchState>(PackedState);
+
+	Ar << ServerTimerEnd;
+
+	uint32 NumSlots = Statuses.Num();
+	Ar.SerializeIntPacked(NumSlots);
+
+	// slots fit in a byte, see FPMBallot
+	bOutSuccess = (NumSlots <= FPMBallot::NoSuspect);
+	if (!bOutSuccess)
+	{
+		return true;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Statuses.SetNum(NumSlots);
+		Voted.SetNum(NumSlots);
+		Votes.SetNum(NumSlots);
+	}
+
+	// votes are only revealed in deliberation, anywhere else a bit per slot says all there is
+	const bool bRevealed = (MatchState == EMatchState::Deliberation);
+	for (uint32 Slot = 0; Slot < NumSlots; ++Slot)
+	{
+		uint8 PackedStatus = static_cast<uint8>(Statuses[Slot]);
+		uint8 bPackedVoted = Voted[Slot] ? 1 : 0;
+		Ar.SerializeBits(&PackedStatus, 3);
+		Ar.SerializeBits(&bPackedVoted, 1);
+
+		uint8 Suspect = (Votes[Slot] != INDEX_NONE) ? static_cast<uint8>(Votes[Slot]) : FPMBallot::NoSuspect;
+		if (bRevealed)
+		{
+			Ar << Suspect;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Statuses[Slot] = static_cast<EPlayerMatchStatus>(PackedStatus);
+			Voted[Slot] = (bPackedVoted != 0);
+			Votes[Slot] = (bRevealed && (Suspect != FPMBallot::NoSuspect)) ? Suspect : INDEX_NONE;
+		}
+	}
+
+	return true;
+}
+
+APMMatch::APMMatch()
+{
+	bReplicates = true;
+	bAlwaysRelevant = false;
+	NetUpdateFrequency = 10.f;
+
+	VoteTracker = CreateDefaultSubobject<UPMVoteTracker>(TEXT("VoteTracker"));
+}
+
+APMMatch* APMMatch::GetViewerMatch(const AActor* RealViewer)
+{
+	const APlayerController* Viewer = Cast<APlayerController>(RealViewer);
+	const APMPlayerState* ViewerState = Viewer ? Viewer->GetPlayerState<APMPlayerState>() : nullptr;
+	return ViewerState ? ViewerState->GetMatch() : nullptr;
+}
+
+void APMMatch::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMMatch, MatchState, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMMatch, ServerTimerEnd, Params);
+
+	Params.Condition = COND_InitialOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMMatch, MatchIndex, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMMatch, Origin, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMMatch, Level, Params);
+}
+
+bool APMMatch::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return GetViewerMatch(RealViewer) == this;
+}
+
+void APMMatch::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	PushModelValidator.Validate(*this);
+}
+
+void APMMatch::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// clients only ever receive their own match, so they load the same instance the server did
+	if (!Level.IsNull())
+	{
+		bool bSuccess = false;
+		LevelInstance = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(this, Level, Origin, FRotator::ZeroRotator, bSuccess);
+		if (bSuccess)
+		{
+			LevelInstance->OnLevelShown.AddDynamic(this, &APMMatch::OnLevelShown);
+		}
+		else
+		{
+			UE_LOG(LogPuppetMaster, Error, TEXT("Match %d failed to load %s"), MatchIndex, *Level.ToString());
+		}
+	}
+
+	UpdateLocalView();
+}
+
+void APMMatch::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(MatchTimerHandle);
+
+	if (LevelInstance)
+	{
+		LevelInstance->SetIsRequestingUnloadAndRemoval(true);
+		LevelInstance = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APMMatch::InitMatch(int32 InMatchIndex, const FVector& InOrigin, const TSoftObjectPtr<UWorld>& InLevel, const FPMMatchRulesConfig& RulesConfig)
+{
+	check(HasAuthority() && !HasActorBegunPlay());
+
+	MatchIndex = InMatchIndex;
+	Origin = InOrigin;
+	Level = InLevel;
+	Rules = FPMMatchRules(RulesConfig, FMath::Rand());
+
+	PM_MARK_PROPERTY_DIRTY(APMMatch, MatchIndex);
+	PM_MARK_PROPERTY_DIRTY(APMMatch, Origin);
+	PM_MARK_PROPERTY_DIRTY(APMMatch, Level);
+}
+
+ULevel* APMMatch::GetLoadedLevel() const
+{
+	return LevelInstance ? LevelInstance->GetLoadedLevel() : nullptr;
+}
+
+void APMMatch::SetMatchState(EMatchState State)
+{
+	if (MatchState != State)
+	{
+		PrevMatchState = MatchState;
+		MatchState = State;
+		PM_MARK_PROPERTY_DIRTY(APMMatch, MatchState);
+
+		OnMatchStateChanged();
+	}
+}
+
+bool APMMatch::IsServerTimerActive() const
+{
+	return ServerTimerEnd != 0.f;
+}
+
+float APMMatch::GetServerTimerRemainingTime() const
+{
+	return FMath::Max(0.f, ServerTimerEnd - GetWorld()->GetGameState()->GetServerWorldTimeSeconds());
+}
+
+void APMMatch::StartServerTimer(float TimerLength)
+{
+	ServerTimerEnd = GetWorld()->GetGameState()->GetServerWorldTimeSeconds() + TimerLength;
+	PM_MARK_PROPERTY_DIRTY(APMMatch, ServerTimerEnd);
+	UpdateLocalView();
+}
+
+void APMMatch::ClearServerTimer()
+{
+	ServerTimerEnd = 0.f;
+	PM_MARK_PROPERTY_DIRTY(APMMatch, ServerTimerEnd);
+	UpdateLocalView();
+}
+
+bool APMMatch::AddPlayer(APMPlayerState& Player)
+{
+	check(HasAuthority());
+	check(!Players.Contains(&Player));
+
+	const int32 Slot = Rules.AddPlayer();
+	if (Slot == INDEX_NONE)
+	{
+		UE_LOG(LogPuppetMaster, Warning, TEXT("Match %d has no slot left for %s"), MatchIndex, *Player.GetPlayerName());
+		return false;
+	}
+
+	Players.Add(&Player);
+	Player.SetMatch(this, Slot);
+	Player.SetStatus(ToPlayerMatchStatus(Rules.GetStatus(Slot)));
+	return true;
+}
+
+EMatchAction APMMatch::RemovePlayer(APMPlayerState& Player)
+{
+	check(HasAuthority());
+
+	const EMatchAction Action = Rules.RemovePlayer(Player.GetMatchSlot());
+	VoteTracker->SetVoted(Player.GetMatchSlot(), false);
+
+	DetachPlayer(Player);
+
+	return Action;
+}
+
+void APMMatch::DetachPlayer(APMPlayerState& Player)
+{
+	check(HasAuthority());
+
+	Players.RemoveSingle(&Player);
+	Player.SetMatch(nullptr, INDEX_NONE);
+}
+
+void APMMatch::ResetPlayers()
+{
+	check(HasAuthority());
+	check(Rules.GetNumSlots() == 0);
+
+	for (APMPlayerState* Player : Players)
+	{
+		Player->SetMatch(this, Rules.AddPlayer());
+		Player->SetStatus(ToPlayerMatchStatus(Rules.GetStatus(Player->GetMatchSlot())));
+	}
+
+	VoteTracker->ResetVotes();
+	MatchSummary = FPMMatchSummary();
+	MatchStartTime = 0.f;
+}
+
+void APMMatch::SyncPlayers()
+{
+	check(HasAuthority());
+
+	for (APMPlayerState* Player : Players)
+	{
+		if (!Player->IsDisconnected())
+		{
+			Player->SetStatus(ToPlayerMatchStatus(Rules.GetStatus(Player->GetMatchSlot())));
+		}
+	}
+}
+
+FPMMatchSnapshot APMMatch::MakeSnapshot() const
+{
+	check(HasAuthority());
+
+	FPMMatchSnapshot Snapshot;
+	Snapshot.MatchState = MatchState;
+	Snapshot.ServerTimerEnd = ServerTimerEnd;
+
+	const int32 NumSlots = Rules.GetNumSlots();
+	Snapshot.Statuses.Init(EPlayerMatchStatus::Disconnected, NumSlots);
+	Snapshot.Voted.Init(false, NumSlots);
+	Snapshot.Votes.Init(INDEX_NONE, NumSlots);
+
+	// players who left have no player state anymore, which is what the default says
+	for (const APMPlayerState* Player : Players)
+	{
+		Snapshot.Statuses[Player->GetMatchSlot()] = Player->GetStatus();
+	}
+
+	for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+	{
+		Snapshot.Voted[Slot] = Rules.HasVoted(Slot);
+		if (MatchState == EMatchState::Deliberation)
+		{
+			Snapshot.Votes[Slot] = Snapshot.Voted[Slot] ? Rules.GetVote(Slot) : INDEX_NONE;
+		}
+	}
+
+	return Snapshot;
+}
+
+void APMMatch::ForEachPlayerController(const TFunctionRef<void(APMPlayerController& PlayerController)>& DoThis) const
+{
+	for (APMPlayerState* Player : Players)
+	{
+		if (APMPlayerController* PlayerController = Cast<APMPlayerController>(Player->GetOwner()))
+		{
+			DoThis(*PlayerController);
+		}
+	}
+}
+
+void APMMatch::AddCharacter(APMCharacter& Character, int32 Slot)
+{
+	check(HasAuthority());
+
+	Characters.AddUnique(&Character);
+	Character.SetMatch(this, Slot);
+}
+
+void APMMatch::RemoveCharacter(APMCharacter& Character)
+{
+	Characters.RemoveSingleSwap(&Character);
+}
+
+void APMMatch::UpdateLocalView() const
+{
+	APMGameState* GameState = GetWorld()->GetGameState<APMGameState>();
+	if (GameState && IsLocalPlayerMatch())
+	{
+		GameState->ShowMatch(*this);
+	}
+}
+
+bool APMMatch::IsLocalPlayerMatch() const
+{
+	const APlayerController* LocalPlayer = GEngine->GetFirstLocalPlayerController(GetWorld());
+	const APMPlayerState* LocalPlayerState = LocalPlayer ? LocalPlayer->GetPlayerState<APMPlayerState>() : nullptr;
+	return LocalPlayerState && (LocalPlayerState->GetMatch() == this);
+}
+
+void APMMatch::SendMatchSummary(const FPMMatchSummary& Summary)
+{
+	check(HasAuthority());
+
+	// only the match's own players see the match, so only they get this
+	MulticastMatchSummary(Summary);
+}
+
+void APMMatch::MulticastMatchSummary_Implementation(const FPMMatchSummary& Summary)
+{
+	MatchSummary = Summary;
+	UpdateLocalView();
+}
+
+void APMMatch::OnRep_MatchState(EMatchState OldMatchState)
+{
+	PrevMatchState = OldMatchState;
+	OnMatchStateChanged();
+}
+
+void APMMatch::OnMatchStateChanged()
+{
+	UpdateLocalView();
+
+	// reset in place, the next match starts with the map unexplored
+	if ((PrevMatchState == EMatchState::PostMatch) && (MatchState == EMatchState::WaitingToStart) && IsLocalPlayerMatch())
+	{
+		if (UPMFogOfWarSubsystem* FogOfWar = GetWorld()->GetSubsystem<UPMFogOfWarSubsystem>())
+		{
+			FogOfWar->ResetFog();
+		}
+	}
+}
+
+void APMMatch::OnRep_ServerTimerEnd()
+{
+	UpdateLocalView();
+}
+
+void APMMatch::OnLevelShown()
+{
+	// the occluders were extracted without this instance's walls
+	if (UPMOccluderSubsystem* Occluders = GetWorld()->GetSubsystem<UPMOccluderSubsystem>())
+	{
+		Occluders->InvalidateOccluders();
+	}
+}
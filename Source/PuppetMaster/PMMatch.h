@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMGameMode.h"
+#include "PMMatchRules.h"
+#include "PMMatchTypes.h"
+#include "PMPushModel.h"
+
+#include "GameFramework/Info.h"
+
+#include "PMMatch.generated.h"
+
+class APMCharacter;
+class APMPlayerController;
+class APMPlayerState;
+class ULevelStreamingDynamic;
+
+/**
+ * One lobby hosted by the server. Several matches can run side by side in the same world, each in its own instance
+ * of the match level streamed in at Origin, so state, timer, players and puppets all live here rather than on the
+ * game mode or game state. What the match is allowed to do next is up to its FPMMatchRules, the game mode only
+ * carries out their decisions.
+ * Only replicated to the players in it; on their machines APMGameState mirrors it for UI.
+ */
+UCLASS(notplaceable)
+class APMMatch : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+
+	APMMatch();
+
+	/** The match the connection of RealViewer plays in, if any. */
+	static APMMatch* GetViewerMatch(const AActor* RealViewer);
+
+	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Server only, sets where the match is hosted and what it plays by. Must be called before the match begins play. */
+	void InitMatch(int32 InMatchIndex, const FVector& InOrigin, const TSoftObjectPtr<UWorld>& InLevel, const FPMMatchRulesConfig& RulesConfig);
+
+	int32 GetMatchIndex() const { return MatchIndex; }
+	const FVector& GetOrigin() const { return Origin; }
+
+	/** The streamed in match level, null when the match is played in the persistent level. */
+	ULevel* GetLoadedLevel() const;
+
+	bool InMatchState(EMatchState State) const { return State == MatchState; }
+	EMatchState GetMatchState() const { return MatchState; }
+	EMatchState GetPrevMatchState() const { return PrevMatchState; }
+	void SetMatchState(EMatchState State);
+
+	bool IsServerTimerActive() const;
+	float GetServerTimerEnd() const { return ServerTimerEnd; }
+	float GetServerTimerRemainingTime() const;
+
+	void StartServerTimer(float TimerLength);
+	void ClearServerTimer();
+
+	/** The rules decide, server only. */
+	FPMMatchRules& GetRules() { return Rules; }
+	const FPMMatchRules& GetRules() const { return Rules; }
+
+	/** Returns false if the rules have no slot left for the player, who then isn't in the match. */
+	bool AddPlayer(APMPlayerState& Player);
+
+	/** Returns what the rules make of the player leaving. */
+	EMatchAction RemovePlayer(APMPlayerState& Player);
+
+	/** Hands the players still in the match new slots after the rules were reset, and forgets the last match. */
+	void ResetPlayers();
+
+	/** Takes the player out of the match without telling the rules, e.g. once they were reset. */
+	void DetachPlayer(APMPlayerState& Player);
+
+	/** Copies every player's status out of the rules, for clients to see. Disconnected players keep showing that. */
+	void SyncPlayers();
+
+	class UPMVoteTracker* GetVoteTracker() const { return VoteTracker; }
+
+	const TArray<APMPlayerState*>& GetPlayers() const { return Players; }
+	int32 GetNumPlayers() const { return Players.Num(); }
+
+	void ForEachPlayerController(const TFunctionRef<void(APMPlayerController& PlayerController)>& DoThis) const;
+
+	/** Slot is the one of the player the puppet was spawned for. */
+	void AddCharacter(APMCharacter& Character, int32 Slot);
+	void RemoveCharacter(APMCharacter& Character);
+
+	/** Every puppet spawned for the match, bodies included. */
+	const TArray<APMCharacter*>& GetCharacters() const { return Characters; }
+
+	/** Pushes the match into the game state if the local player plays in it. */
+	void UpdateLocalView() const;
+
+	bool IsLocalPlayerMatch() const;
+
+	/** Server only, tells the players how the match went. */
+	void SendMatchSummary(const FPMMatchSummary& Summary);
+
+	/** Server only, see FPMMatchSnapshot. */
+	FPMMatchSnapshot MakeSnapshot() const;
+
+	/** Empty until the match is over. */
+	const FPMMatchSummary& GetMatchSummary() const { return MatchSummary; }
+
+	// state machine bookkeeping, owned by APMGameModeBase
+	FTimerHandle MatchTimerHandle;
+	float MatchStartTime = 0.f;
+
+protected:
+
+	UFUNCTION()
+	void OnRep_MatchState(EMatchState OldMatchState);
+
+	UFUNCTION()
+	void OnRep_ServerTimerEnd();
+
+	UFUNCTION()
+	void OnLevelShown();
+
+	void OnMatchStateChanged();
+
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastMatchSummary(const FPMMatchSummary& Summary);
+	void MulticastMatchSummary_Implementation(const FPMMatchSummary& Summary);
+
+private:
+
+	UPROPERTY(Replicated)
+	int32 MatchIndex = 0;
+
+	UPROPERTY(Replicated)
+	FVector Origin = FVector::ZeroVector;
+
+	UPROPERTY(Replicated)
+	TSoftObjectPtr<UWorld> Level;
+
+	UPROPERTY(ReplicatedUsing = OnRep_MatchState)
+	EMatchState MatchState = EMatchState::WaitingToStart;
+
+	EMatchState PrevMatchState = EMatchState::PostMatch;
+
+	/** The time at which the server's current timer will end. */
+	UPROPERTY(ReplicatedUsing = OnRep_ServerTimerEnd)
+	float ServerTimerEnd = 0.f;
+
+	UPROPERTY(Transient)
+	ULevelStreamingDynamic* LevelInstance = nullptr;
+
+	UPROPERTY(VisibleAnywhere)
+	class UPMVoteTracker* VoteTracker;
+
+	UPROPERTY(Transient)
+	TArray<APMPlayerState*> Players;
+
+	UPROPERTY(Transient)
+	TArray<APMCharacter*> Characters;
+
+	UPROPERTY(Transient)
+	FPMMatchSummary MatchSummary;
+
+	FPMMatchRules Rules;
+
+	FPMPushModelValidator PushModelValidator;
+
+};
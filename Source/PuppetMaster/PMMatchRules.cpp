@@ -0,0 +1,483 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMMatchRules.h"
+
+FPMMatchRules::FPMMatchRules(const FPMMatchRulesConfig& InConfig, int32 Seed)
+	: Config(InConfig)
+	, Random(Seed)
+{
+}
+
+void FPMMatchRules::Reset()
+{
+	State = ERulesState::WaitingToStart;
+	Outcome = ERulesOutcome::None;
+	bCountdownActive = false;
+	EjectedPlayer = INDEX_NONE;
+
+	Status.Reset();
+	Health.Reset();
+	Votes.Reset();
+	Tally.Reset();
+	Incapacitated.Empty();
+	Killers.Empty();
+	Voted.Empty();
+
+	NumConnected = 0;
+	NumReady = 0;
+	NumVoted = 0;
+	NumSkips = 0;
+	NumEjections = 0;
+
+	InnocentHeadCount = FPMHeadCount();
+	KillerHeadCount = FPMHeadCount();
+}
+
+int32 FPMMatchRules::AddPlayer()
+{
+	// nobody holds on to the slot of someone who left before the start
+	int32 Slot = (State == ERulesState::WaitingToStart) ? Status.Find(ERulesSlotStatus::Disconnected) : INDEX_NONE;
+	if (Slot == INDEX_NONE)
+	{
+		if (Status.Num() >= MaxSlots)
+		{
+			return INDEX_NONE;
+		}
+
+		Slot = Status.AddUninitialized();
+		Health.AddUninitialized();
+		Votes.AddUninitialized();
+		Tally.AddUninitialized();
+		Incapacitated.Add(false);
+		Killers.Add(false);
+		Voted.Add(false);
+	}
+
+	InitSlot(Slot);
+	++NumConnected;
+
+	return Slot;
+}
+
+void FPMMatchRules::InitSlot(int32 Slot)
+{
+	Status[Slot] = ERulesSlotStatus::NotReady;
+	Health[Slot] = Config.HealthMax;
+	Votes[Slot] = INDEX_NONE;
+	Tally[Slot] = 0;
+	Incapacitated[Slot] = false;
+	Killers[Slot] = false;
+	Voted[Slot] = false;
+}
+
+EMatchAction FPMMatchRules::RemovePlayer(int32 Slot)
+{
+	if (Status[Slot] == ERulesSlotStatus::Disconnected)
+	{
+		return EMatchAction::None;
+	}
+
+	NumReady -= (Status[Slot] == ERulesSlotStatus::Ready) ? 1 : 0;
+	ClearVote(Slot);
+
+	// someone who left is out of the match, but nobody killed them
+	if (IsAlive(Slot))
+	{
+		FPMHeadCount& HeadCount = GetHeadCount(Slot);
+		HeadCount.Alive -= 1;
+		HeadCount.Incapacitated -= Incapacitated[Slot] ? 1 : 0;
+	}
+
+	Status[Slot] = ERulesSlotStatus::Disconnected;
+	--NumConnected;
+
+	// whoever is left may be all the match was waiting on
+	switch (State)
+	{
+	case ERulesState::WaitingToStart:
+		return CheckReadiness();
+	case ERulesState::Voting:
+		return CheckVotes();
+	case ERulesState::Investigation:
+		return CheckOutcome();
+	default:
+		return EMatchAction::None;
+	}
+}
+
+EMatchAction FPMMatchRules::SetReady(int32 Slot, bool bReady)
+{
+	if (State != ERulesState::WaitingToStart || (Status[Slot] == ERulesSlotStatus::Disconnected))
+	{
+		return EMatchAction::None;
+	}
+
+	const ERulesSlotStatus NewStatus = bReady ? ERulesSlotStatus::Ready : ERulesSlotStatus::NotReady;
+	if (Status[Slot] != NewStatus)
+	{
+		Status[Slot] = NewStatus;
+		NumReady += bReady ? 1 : -1;
+		check(NumReady >= 0);
+	}
+
+	return CheckReadiness();
+}
+
+EMatchAction FPMMatchRules::CastVote(int32 Slot, int32 Suspect)
+{
+	check(Suspect == INDEX_NONE || Status.IsValidIndex(Suspect));
+
+	if ((State != ERulesState::Voting) || !IsAlive(Slot) || ((Suspect != INDEX_NONE) && !IsAlive(Suspect)))
+	{
+		return EMatchAction::None;
+	}
+
+	// the tally follows every ballot, so closing the vote needs no recount
+	if (Voted[Slot])
+	{
+		UncountVote(Slot);
+	}
+	else
+	{
+		Voted[Slot] = true;
+		++NumVoted;
+	}
+
+	Votes[Slot] = Suspect;
+	(Suspect == INDEX_NONE ? NumSkips : Tally[Suspect]) += 1;
+
+	return CheckVotes();
+}
+
+void FPMMatchRules::ClearVote(int32 Slot)
+{
+	if (Voted[Slot])
+	{
+		UncountVote(Slot);
+
+		Voted[Slot] = false;
+		Votes[Slot] = INDEX_NONE;
+		--NumVoted;
+		check(NumVoted >= 0);
+	}
+}
+
+void FPMMatchRules::UncountVote(int32 Slot)
+{
+	(Votes[Slot] == INDEX_NONE ? NumSkips : Tally[Votes[Slot]]) -= 1;
+}
+
+EHitOutcome FPMMatchRules::Hit(int32 Slot, int32 HitPoints)
+{
+	// passed out puppets get revived, not finished off
+	if (!IsAlive(Slot) || Incapacitated[Slot])
+	{
+		return EHitOutcome::None;
+	}
+
+	AdjustHealth(Slot, -HitPoints);
+	Incapacitated[Slot] = true;
+
+	FPMHeadCount& HeadCount = GetHeadCount(Slot);
+	if (Health[Slot] > 0)
+	{
+		HeadCount.Incapacitated += 1;
+		return EHitOutcome::PassedOut;
+	}
+
+	Status[Slot] = ERulesSlotStatus::Dead;
+	HeadCount.Alive -= 1;
+	HeadCount.Dead += 1;
+	return EHitOutcome::Died;
+}
+
+void FPMMatchRules::AdjustHealth(int32 Slot, int32 AdjustAmount)
+{
+	Health[Slot] = FMath::Clamp(Health[Slot] + AdjustAmount, 0, Config.HealthMax);
+}
+
+bool FPMMatchRules::Revive(int32 Slot)
+{
+	if (!IsAlive(Slot) || !Incapacitated[Slot])
+	{
+		return false;
+	}
+
+	Incapacitated[Slot] = false;
+	GetHeadCount(Slot).Incapacitated -= 1;
+	return true;
+}
+
+EMatchAction FPMMatchRules::HandleEvent(EMatchEvent Event)
+{
+	struct FMatchTransition
+	{
+		ERulesState State;
+		EMatchEvent Event;
+		EMatchAction Action;
+	};
+
+	static const FMatchTransition Transitions[] =
+	{
+		{ ERulesState::WaitingToStart,	EMatchEvent::PlayersReady,		EMatchAction::StartCountdown },
+		{ ERulesState::WaitingToStart,	EMatchEvent::PlayersNotReady,	EMatchAction::CancelCountdown },
+		{ ERulesState::WaitingToStart,	EMatchEvent::TimerExpired,		EMatchAction::StartMatch },
+		{ ERulesState::Investigation,	EMatchEvent::MeetingCalled,		EMatchAction::EnterDiscussion },
+		{ ERulesState::Investigation,	EMatchEvent::BodyReported,		EMatchAction::EnterDiscussion },
+		{ ERulesState::Discussion,		EMatchEvent::TimerExpired,		EMatchAction::EnterVoting },
+		{ ERulesState::Voting,			EMatchEvent::TimerExpired,		EMatchAction::EnterDeliberation },
+		{ ERulesState::Voting,			EMatchEvent::PlayersVoted,		EMatchAction::EnterDeliberation },
+		{ ERulesState::Deliberation,	EMatchEvent::TimerExpired,		EMatchAction::ResumeInvestigation }, // unless the match is over
+		{ ERulesState::PostMatch,		EMatchEvent::TimerExpired,		EMatchAction::ResetMatch },
+	};
+
+	EMatchAction Action = EMatchAction::None;
+	for (const FMatchTransition& Transition : Transitions)
+	{
+		if ((Transition.State == State) && (Transition.Event == Event))
+		{
+			Action = Transition.Action;
+			break;
+		}
+	}
+
+	switch (Action)
+	{
+	case EMatchAction::StartCountdown:
+		if (bCountdownActive)
+		{
+			return EMatchAction::None;
+		}
+		bCountdownActive = true;
+		break;
+
+	case EMatchAction::CancelCountdown:
+		if (!bCountdownActive)
+		{
+			return EMatchAction::None;
+		}
+		bCountdownActive = false;
+		break;
+
+	case EMatchAction::StartMatch:
+		StartMatch();
+		break;
+
+	case EMatchAction::EnterDiscussion:
+		State = ERulesState::Discussion;
+		break;
+
+	case EMatchAction::EnterVoting:
+		OpenVoting();
+		break;
+
+	case EMatchAction::EnterDeliberation:
+		CloseVoting();
+		break;
+
+	case EMatchAction::ResumeInvestigation:
+		State = ERulesState::Investigation;
+		if (CheckOutcome() == EMatchAction::EndMatch)
+		{
+			Action = EMatchAction::EndMatch;
+		}
+		break;
+
+	case EMatchAction::ResetMatch:
+		Reset();
+		break;
+
+	default:
+		break;
+	}
+
+	return Action;
+}
+
+float FPMMatchRules::GetTimerLength() const
+{
+	switch (State)
+	{
+	case ERulesState::WaitingToStart:
+		return bCountdownActive ? Config.StartDelay : 0.f;
+	case ERulesState::Discussion:
+		return Config.DiscussionLength;
+	case ERulesState::Voting:
+		return Config.VotingLength;
+	case ERulesState::Deliberation:
+		return Config.DeliberationLength;
+	case ERulesState::PostMatch:
+		return Config.PostMatchLength;
+	default:
+		return 0.f;
+	}
+}
+
+ERulesOutcome FPMMatchRules::EvaluateOutcome() const
+{
+	if (State == ERulesState::WaitingToStart)
+	{
+		return ERulesOutcome::None;
+	}
+
+	if (KillerHeadCount.Alive == 0)
+	{
+		return ERulesOutcome::InnocentsWin;
+	}
+
+	// the innocents can no longer outvote them, or nobody is left on their feet to report or revive
+	if ((KillerHeadCount.Alive >= InnocentHeadCount.Alive) || (InnocentHeadCount.GetStanding() == 0))
+	{
+		return ERulesOutcome::KillersWin;
+	}
+
+	return ERulesOutcome::None;
+}
+
+EMatchAction FPMMatchRules::CheckOutcome()
+{
+	if (State != ERulesState::Investigation)
+	{
+		return EMatchAction::None;
+	}
+
+	const ERulesOutcome NewOutcome = EvaluateOutcome();
+	if (NewOutcome == ERulesOutcome::None)
+	{
+		return EMatchAction::None;
+	}
+
+	EndMatch(NewOutcome);
+	return EMatchAction::EndMatch;
+}
+
+EMatchAction FPMMatchRules::CheckReadiness()
+{
+	if (State != ERulesState::WaitingToStart)
+	{
+		return EMatchAction::None;
+	}
+
+	const bool bAllReady = (NumReady == NumConnected) && (NumConnected >= Config.MinNumPlayers);
+	return HandleEvent(bAllReady ? EMatchEvent::PlayersReady : EMatchEvent::PlayersNotReady);
+}
+
+EMatchAction FPMMatchRules::CheckVotes()
+{
+	if ((State != ERulesState::Voting) || (NumVoted < GetNumLivingPlayers()))
+	{
+		return EMatchAction::None;
+	}
+
+	return HandleEvent(EMatchEvent::PlayersVoted);
+}
+
+void FPMMatchRules::StartMatch()
+{
+	State = ERulesState::Investigation;
+	Outcome = ERulesOutcome::None;
+	bCountdownActive = false;
+	EjectedPlayer = INDEX_NONE;
+	NumReady = 0;
+	NumEjections = 0;
+	InnocentHeadCount = FPMHeadCount();
+	KillerHeadCount = FPMHeadCount();
+
+	TArray<int32, TInlineAllocator<16>> Candidates;
+	for (int32 Slot = 0; Slot < Status.Num(); ++Slot)
+	{
+		if (Status[Slot] != ERulesSlotStatus::Disconnected)
+		{
+			Status[Slot] = ERulesSlotStatus::Alive;
+			Health[Slot] = Config.HealthMax;
+			Incapacitated[Slot] = false;
+			Killers[Slot] = false;
+			Candidates.Add(Slot);
+		}
+	}
+
+	// partial shuffle, and at least one innocent is left to hunt
+	const int32 NumToPick = FMath::Min(Config.NumKillers, Candidates.Num() - 1);
+	for (int32 Index = 0; Index < NumToPick; ++Index)
+	{
+		Candidates.Swap(Index, Random.RandRange(Index, Candidates.Num() - 1));
+		Killers[Candidates[Index]] = true;
+	}
+
+	for (const int32 Slot : Candidates)
+	{
+		GetHeadCount(Slot).Alive += 1;
+	}
+}
+
+void FPMMatchRules::OpenVoting()
+{
+	State = ERulesState::Voting;
+	EjectedPlayer = INDEX_NONE;
+
+	for (int32 Slot = 0; Slot < Status.Num(); ++Slot)
+	{
+		Votes[Slot] = INDEX_NONE;
+		Tally[Slot] = 0;
+	}
+	Voted.Init(false, Status.Num());
+	NumVoted = 0;
+	NumSkips = 0;
+}
+
+void FPMMatchRules::CloseVoting()
+{
+	State = ERulesState::Deliberation;
+
+	// only a clear majority over every other suspect and the skips throws someone out
+	int32 TopSuspect = INDEX_NONE;
+	int32 TopVotes = 0;
+	bool bTied = false;
+	for (int32 Slot = 0; Slot < Tally.Num(); ++Slot)
+	{
+		if (Tally[Slot] > TopVotes)
+		{
+			TopSuspect = Slot;
+			TopVotes = Tally[Slot];
+			bTied = false;
+		}
+		else if ((Tally[Slot] == TopVotes) && (TopVotes > 0))
+		{
+			bTied = true;
+		}
+	}
+
+	if ((TopSuspect != INDEX_NONE) && !bTied && (TopVotes > NumSkips) && IsAlive(TopSuspect))
+	{
+		FPMHeadCount& HeadCount = GetHeadCount(TopSuspect);
+		HeadCount.Alive -= 1;
+		HeadCount.Incapacitated -= Incapacitated[TopSuspect] ? 1 : 0;
+		HeadCount.Dead += 1;
+		NumEjections += 1;
+
+		Status[TopSuspect] = ERulesSlotStatus::Dead;
+		Health[TopSuspect] = 0;
+		Incapacitated[TopSuspect] = true;
+		EjectedPlayer = TopSuspect;
+	}
+}
+
+void FPMMatchRules::EndMatch(ERulesOutcome InOutcome)
+{
+	State = ERulesState::PostMatch;
+	Outcome = InOutcome;
+}
+
+const TCHAR* LexToString(EMatchEvent Event)
+{
+	switch (Event)
+	{
+	case EMatchEvent::PlayersReady: return TEXT("PlayersReady");
+	case EMatchEvent::PlayersNotReady: return TEXT("PlayersNotReady");
+	case EMatchEvent::TimerExpired: return TEXT("TimerExpired");
+	case EMatchEvent::MeetingCalled: return TEXT("MeetingCalled");
+	case EMatchEvent::BodyReported: return TEXT("BodyReported");
+	case EMatchEvent::PlayersVoted: return TEXT("PlayersVoted");
+	default: return TEXT("Unknown");
+	}
+}
@@ -0,0 +1,149 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMMatchRulesTypes.h"
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+/** The tunables of a match, the game mode fills them in from its config. */
+struct FPMMatchRulesConfig
+{
+	int32 HealthMax = 2;
+	int32 MinNumPlayers = 2;
+	int32 NumKillers = 1;
+	float StartDelay = 3.f;
+	float DiscussionLength = 30.f;
+	float VotingLength = 30.f;
+	float DeliberationLength = 10.f;
+
+	/** How long the result is shown before the match resets for the next one, zero to keep it over. */
+	float PostMatchLength = 15.f;
+};
+
+/**
+ * The rules of one match, free of any engine objects so a match can be played by the game mode as well as by a
+ * headless simulation, see UPMSimulateCommandlet.
+ * The rules only decide; timers, puppets and input are the owner's business, driven by the EMatchAction every
+ * call that can move the match returns.
+ * Players are kept as parallel arrays indexed by the slot AddPlayer hands out. Once the match has started slots stay
+ * taken until the rules are reset, so a slot held by the engine side never points at someone else. Before that the slot
+ * of a player who left goes to the next one to join, so players coming and going in the lobby don't add up.
+ */
+class FPMMatchRules
+{
+public:
+
+	FPMMatchRules() = default;
+	explicit FPMMatchRules(const FPMMatchRulesConfig& InConfig, int32 Seed = 0);
+
+	const FPMMatchRulesConfig& GetConfig() const { return Config; }
+
+	/** Back to waiting for players, with none. The owner adds whoever is still connected again, in new slots. */
+	void Reset();
+
+	/** Slots go over the wire as a byte, with one value left for nobody, see FPMBallot. */
+	static constexpr int32 MaxSlots = 255;
+
+	/** Returns the new player's slot, or INDEX_NONE if the match has no slot left to give. */
+	int32 AddPlayer();
+	EMatchAction RemovePlayer(int32 Slot);
+
+	int32 GetNumSlots() const { return Status.Num(); }
+	int32 GetNumConnectedPlayers() const { return NumConnected; }
+
+	ERulesSlotStatus GetStatus(int32 Slot) const { return Status[Slot]; }
+	int32 GetHealth(int32 Slot) const { return Health[Slot]; }
+	bool IsAlive(int32 Slot) const { return Status[Slot] == ERulesSlotStatus::Alive; }
+	bool IsIncapacitated(int32 Slot) const { return Incapacitated[Slot]; }
+	bool IsKiller(int32 Slot) const { return Killers[Slot]; }
+
+	/** Only counts while waiting to start. */
+	EMatchAction SetReady(int32 Slot, bool bReady);
+
+	/** Only counts while voting, by and against the living. Suspect is INDEX_NONE to skip; voting again changes the vote. */
+	EMatchAction CastVote(int32 Slot, int32 Suspect);
+	void ClearVote(int32 Slot);
+	bool HasVoted(int32 Slot) const { return Voted[Slot]; }
+	int32 GetVote(int32 Slot) const { return Votes[Slot]; }
+
+	/** Knocks a standing puppet down, for good once its health runs out. */
+	EHitOutcome Hit(int32 Slot, int32 HitPoints);
+	void AdjustHealth(int32 Slot, int32 AdjustAmount);
+
+	/** Gets a passed out puppet back on its feet. Returns false if there was nothing to revive. */
+	bool Revive(int32 Slot);
+
+	ERulesState GetState() const { return State; }
+
+	/** Looks the event up in the transition table for the current state. Events a state doesn't handle are ignored. */
+	EMatchAction HandleEvent(EMatchEvent Event);
+
+	/** How long the timer of the current state runs, zero when it has none. */
+	float GetTimerLength() const;
+
+	/** Who the last vote threw out, INDEX_NONE if nobody. */
+	int32 GetEjectedPlayer() const { return EjectedPlayer; }
+
+	ERulesOutcome GetOutcome() const { return Outcome; }
+
+	/** Who has won with the players as they are, None while both sides still stand a chance. */
+	ERulesOutcome EvaluateOutcome() const;
+
+	/**
+	 * Ends the match during investigation as soon as one side has won, call after anyone dropped, got up or left.
+	 * Everywhere else the match plays on until the end of deliberation.
+	 */
+	EMatchAction CheckOutcome();
+
+	/** Kept up to date as players change, so checking the outcome never needs to look at every player. */
+	const FPMHeadCount& GetInnocentHeadCount() const { return InnocentHeadCount; }
+	const FPMHeadCount& GetKillerHeadCount() const { return KillerHeadCount; }
+
+	int32 GetNumEjections() const { return NumEjections; }
+
+private:
+
+	void InitSlot(int32 Slot);
+
+	EMatchAction CheckReadiness();
+	EMatchAction CheckVotes();
+	void UncountVote(int32 Slot);
+
+	void StartMatch();
+	void OpenVoting();
+	void CloseVoting();
+
+	int32 GetNumLivingPlayers() const { return InnocentHeadCount.Alive + KillerHeadCount.Alive; }
+	FPMHeadCount& GetHeadCount(int32 Slot) { return Killers[Slot] ? KillerHeadCount : InnocentHeadCount; }
+
+	void EndMatch(ERulesOutcome InOutcome);
+
+	FPMMatchRulesConfig Config;
+	FRandomStream Random;
+
+	ERulesState State = ERulesState::WaitingToStart;
+	ERulesOutcome Outcome = ERulesOutcome::None;
+	bool bCountdownActive = false;
+	int32 EjectedPlayer = INDEX_NONE;
+
+	// one entry per slot
+	TArray<ERulesSlotStatus> Status;
+	TArray<int32> Health;
+	TArray<int32> Votes;
+	TArray<int32> Tally;
+	TBitArray<> Incapacitated;
+	TBitArray<> Killers;
+	TBitArray<> Voted;
+
+	int32 NumConnected = 0;
+	int32 NumReady = 0;
+	int32 NumVoted = 0;
+	int32 NumSkips = 0;
+	int32 NumEjections = 0;
+
+	FPMHeadCount InnocentHeadCount;
+	FPMHeadCount KillerHeadCount;
+
+};
@@ -0,0 +1,314 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMMatchRules.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PMMatchRulesTests
+{
+	/** The killer and the innocents of a match that just started, by slot. */
+	struct FCast
+	{
+		int32 Killer = INDEX_NONE;
+		TArray<int32> Innocents;
+	};
+
+	FPMMatchRulesConfig MakeConfig()
+	{
+		FPMMatchRulesConfig Config;
+		Config.HealthMax = 2;
+		Config.MinNumPlayers = 3;
+		Config.NumKillers = 1;
+		return Config;
+	}
+
+	/** Readies NumPlayers simulated players and lets the countdown run out. */
+	bool StartMatch(FAutomationTestBase& Test, FPMMatchRules& Rules, int32 NumPlayers, FCast& OutCast)
+	{
+		for (int32 Index = 0; Index < NumPlayers; ++Index)
+		{
+			Test.TestEqual(TEXT("Slots are handed out in order"), Rules.AddPlayer(), Index);
+		}
+
+		for (int32 Slot = 0; Slot < NumPlayers - 1; ++Slot)
+		{
+			Test.TestTrue(TEXT("No countdown before everyone is ready"), Rules.SetReady(Slot, true) == EMatchAction::None);
+		}
+
+		Test.TestTrue(TEXT("The last ready player starts the countdown"), Rules.SetReady(NumPlayers - 1, true) == EMatchAction::StartCountdown);
+		Test.TestTrue(TEXT("Start timer"), Rules.GetTimerLength() == Rules.GetConfig().StartDelay);
+
+		if (!Test.TestTrue(TEXT("Countdown starts the match"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::StartMatch))
+		{
+			return false;
+		}
+
+		Test.TestTrue(TEXT("Investigating"), Rules.GetState() == ERulesState::Investigation);
+
+		for (int32 Slot = 0; Slot < NumPlayers; ++Slot)
+		{
+			Test.TestTrue(TEXT("Everyone starts alive"), Rules.IsAlive(Slot));
+			Test.TestEqual(TEXT("Everyone starts with full health"), Rules.GetHealth(Slot), Rules.GetConfig().HealthMax);
+
+			if (Rules.IsKiller(Slot))
+			{
+				Test.TestEqual(TEXT("One killer"), OutCast.Killer, INDEX_NONE);
+				OutCast.Killer = Slot;
+			}
+			else
+			{
+				OutCast.Innocents.Add(Slot);
+			}
+		}
+
+		Test.TestEqual(TEXT("Innocents alive"), Rules.GetInnocentHeadCount().Alive, NumPlayers - 1);
+		Test.TestEqual(TEXT("Killers alive"), Rules.GetKillerHeadCount().Alive, 1);
+
+		return OutCast.Killer != INDEX_NONE;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMMatchRulesInnocentsWinTest, "PuppetMaster.MatchRules.InnocentsWin", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMMatchRulesInnocentsWinTest::RunTest(const FString& Parameters)
+{
+	using namespace PMMatchRulesTests;
+
+	// too few players never count down, however ready they are
+	{
+		FPMMatchRules Rules(MakeConfig(), 1);
+		TestTrue(TEXT("Waiting to start"), Rules.GetState() == ERulesState::WaitingToStart);
+		TestEqual(TEXT("No start timer without a countdown"), Rules.GetTimerLength(), 0.f);
+
+		Rules.AddPlayer();
+		TestTrue(TEXT("Alone and ready"), Rules.SetReady(0, true) == EMatchAction::None);
+		TestTrue(TEXT("Alone and gone"), Rules.RemovePlayer(0) == EMatchAction::None);
+	}
+
+	FPMMatchRules Rules(MakeConfig(), 1);
+	FCast Cast;
+	if (!StartMatch(*this, Rules, 4, Cast))
+	{
+		return false;
+	}
+
+	const int32 Killer = Cast.Killer;
+	const int32 Victim = Cast.Innocents[0];
+	const int32 Reporter = Cast.Innocents[1];
+	const int32 Witness = Cast.Innocents[2];
+
+	TestTrue(TEXT("Readiness is ignored once started"), Rules.SetReady(Reporter, false) == EMatchAction::None);
+	TestTrue(TEXT("Votes are ignored outside voting"), Rules.CastVote(Reporter, Killer) == EMatchAction::None);
+	TestTrue(TEXT("Events a state doesn't handle are ignored"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::None);
+	TestTrue(TEXT("Still investigating"), Rules.GetState() == ERulesState::Investigation);
+
+	TestTrue(TEXT("Killed outright"), Rules.Hit(Victim, Rules.GetConfig().HealthMax) == EHitOutcome::Died);
+	TestTrue(TEXT("The dead stay dead"), Rules.Hit(Victim, 1) == EHitOutcome::None);
+	TestTrue(TEXT("One body is no win"), Rules.CheckOutcome() == EMatchAction::None);
+
+	TestTrue(TEXT("Reporting a body"), Rules.HandleEvent(EMatchEvent::BodyReported) == EMatchAction::EnterDiscussion);
+	TestTrue(TEXT("Discussing"), Rules.GetState() == ERulesState::Discussion);
+	TestEqual(TEXT("Discussion timer"), Rules.GetTimerLength(), Rules.GetConfig().DiscussionLength);
+	TestTrue(TEXT("No meeting within a meeting"), Rules.HandleEvent(EMatchEvent::MeetingCalled) == EMatchAction::None);
+
+	TestTrue(TEXT("Discussion runs out"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::EnterVoting);
+	TestTrue(TEXT("Voting"), Rules.GetState() == ERulesState::Voting);
+	TestEqual(TEXT("Voting timer"), Rules.GetTimerLength(), Rules.GetConfig().VotingLength);
+
+	TestTrue(TEXT("The dead don't vote"), Rules.CastVote(Victim, Killer) == EMatchAction::None);
+	TestFalse(TEXT("The dead haven't voted"), Rules.HasVoted(Victim));
+	TestTrue(TEXT("Nobody votes for the dead"), Rules.CastVote(Reporter, Victim) == EMatchAction::None);
+	TestFalse(TEXT("A vote for the dead isn't counted"), Rules.HasVoted(Reporter));
+
+	TestTrue(TEXT("Skipping"), Rules.CastVote(Reporter, INDEX_NONE) == EMatchAction::None);
+	TestTrue(TEXT("Changing the vote"), Rules.CastVote(Reporter, Killer) == EMatchAction::None);
+	TestEqual(TEXT("The changed vote"), Rules.GetVote(Reporter), Killer);
+	TestTrue(TEXT("Witness votes"), Rules.CastVote(Witness, Killer) == EMatchAction::None);
+	TestTrue(TEXT("The last living vote closes voting"), Rules.CastVote(Killer, Witness) == EMatchAction::EnterDeliberation);
+
+	TestTrue(TEXT("Deliberating"), Rules.GetState() == ERulesState::Deliberation);
+	TestEqual(TEXT("Deliberation timer"), Rules.GetTimerLength(), Rules.GetConfig().DeliberationLength);
+	TestEqual(TEXT("The killer is thrown out"), Rules.GetEjectedPlayer(), Killer);
+	TestTrue(TEXT("Ejected means dead"), Rules.GetStatus(Killer) == ERulesSlotStatus::Dead);
+	TestEqual(TEXT("One ejection"), Rules.GetNumEjections(), 1);
+
+	// the match only ends once deliberation is over
+	TestTrue(TEXT("Deliberation runs out on a won match"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::EndMatch);
+	TestTrue(TEXT("Over"), Rules.GetState() == ERulesState::PostMatch);
+	TestTrue(TEXT("Innocents win"), Rules.GetOutcome() == ERulesOutcome::InnocentsWin);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMMatchRulesKillersWinTest, "PuppetMaster.MatchRules.KillersWin", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMMatchRulesKillersWinTest::RunTest(const FString& Parameters)
+{
+	using namespace PMMatchRulesTests;
+
+	// a player who stops being ready calls the countdown off again
+	{
+		FPMMatchRules Rules(MakeConfig(), 7);
+		Rules.AddPlayer();
+		Rules.AddPlayer();
+		Rules.AddPlayer();
+		Rules.SetReady(0, true);
+		Rules.SetReady(1, true);
+		TestTrue(TEXT("Countdown"), Rules.SetReady(2, true) == EMatchAction::StartCountdown);
+		TestTrue(TEXT("Ready twice"), Rules.SetReady(2, true) == EMatchAction::None);
+		TestTrue(TEXT("Not ready after all"), Rules.SetReady(2, false) == EMatchAction::CancelCountdown);
+		TestEqual(TEXT("No start timer"), Rules.GetTimerLength(), 0.f);
+		TestTrue(TEXT("Someone new joins unready"), Rules.SetReady(Rules.AddPlayer(), false) == EMatchAction::None);
+	}
+
+	FPMMatchRules Rules(MakeConfig(), 7);
+	FCast Cast;
+	if (!StartMatch(*this, Rules, 4, Cast))
+	{
+		return false;
+	}
+
+	const int32 Killer = Cast.Killer;
+	const int32 A = Cast.Innocents[0];
+	const int32 B = Cast.Innocents[1];
+	const int32 C = Cast.Innocents[2];
+
+	TestTrue(TEXT("Knocked down"), Rules.Hit(A, 1) == EHitOutcome::PassedOut);
+	TestTrue(TEXT("Passed out"), Rules.IsIncapacitated(A));
+	TestEqual(TEXT("Incapacitated head count"), Rules.GetInnocentHeadCount().Incapacitated, 1);
+	TestTrue(TEXT("Nobody is finished off while down"), Rules.Hit(A, 1) == EHitOutcome::None);
+	TestTrue(TEXT("Revived"), Rules.Revive(A));
+	TestFalse(TEXT("Nothing to revive"), Rules.Revive(A));
+	TestEqual(TEXT("Back on their feet"), Rules.GetInnocentHeadCount().GetStanding(), 3);
+
+	// a tie throws nobody out
+	TestTrue(TEXT("Meeting"), Rules.HandleEvent(EMatchEvent::MeetingCalled) == EMatchAction::EnterDiscussion);
+	TestTrue(TEXT("Voting"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::EnterVoting);
+	Rules.CastVote(A, B);
+	Rules.CastVote(B, A);
+	TestTrue(TEXT("Voting runs out"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::EnterDeliberation);
+	TestEqual(TEXT("Tie"), Rules.GetEjectedPlayer(), INDEX_NONE);
+	TestTrue(TEXT("Back to investigating"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::ResumeInvestigation);
+	TestTrue(TEXT("Investigating"), Rules.GetState() == ERulesState::Investigation);
+
+	// the last holdout leaving closes the vote, and votes against someone who left throw nobody out
+	TestTrue(TEXT("Second meeting"), Rules.HandleEvent(EMatchEvent::MeetingCalled) == EMatchAction::EnterDiscussion);
+	TestTrue(TEXT("Second vote"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::EnterVoting);
+	Rules.CastVote(A, C);
+	Rules.CastVote(B, C);
+	Rules.CastVote(Killer, INDEX_NONE);
+	TestTrue(TEXT("Holdout leaves"), Rules.RemovePlayer(C) == EMatchAction::EnterDeliberation);
+	TestTrue(TEXT("Left"), Rules.GetStatus(C) == ERulesSlotStatus::Disconnected);
+	TestEqual(TEXT("Nobody left to throw out"), Rules.GetEjectedPlayer(), INDEX_NONE);
+	TestEqual(TEXT("Leaving frees no slot"), Rules.GetNumSlots(), 4);
+	TestTrue(TEXT("Two innocents still outnumber one killer"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::ResumeInvestigation);
+
+	TestTrue(TEXT("Health carries over"), Rules.Hit(A, 1) == EHitOutcome::Died);
+	TestTrue(TEXT("Killers win as soon as they can't be outvoted"), Rules.CheckOutcome() == EMatchAction::EndMatch);
+	TestTrue(TEXT("Over"), Rules.GetState() == ERulesState::PostMatch);
+	TestTrue(TEXT("Killers win"), Rules.GetOutcome() == ERulesOutcome::KillersWin);
+	TestTrue(TEXT("A won match takes no more events"), Rules.HandleEvent(EMatchEvent::MeetingCalled) == EMatchAction::None);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMMatchRulesResetTest, "PuppetMaster.MatchRules.ResetAfterMatch", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMMatchRulesResetTest::RunTest(const FString& Parameters)
+{
+	using namespace PMMatchRulesTests;
+
+	FPMMatchRules Rules(MakeConfig(), 5);
+	FCast Cast;
+	if (!StartMatch(*this, Rules, 4, Cast))
+	{
+		return false;
+	}
+
+	// everyone throws the killer out at the first meeting
+	Rules.HandleEvent(EMatchEvent::MeetingCalled);
+	Rules.HandleEvent(EMatchEvent::TimerExpired);
+	for (const int32 Innocent : Cast.Innocents)
+	{
+		Rules.CastVote(Innocent, Cast.Killer);
+	}
+	Rules.CastVote(Cast.Killer, Cast.Innocents[0]);
+	TestTrue(TEXT("Won"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::EndMatch);
+
+	TestEqual(TEXT("Post match timer"), Rules.GetTimerLength(), Rules.GetConfig().PostMatchLength);
+	TestTrue(TEXT("Nothing but the timer ends the post match"), Rules.HandleEvent(EMatchEvent::MeetingCalled) == EMatchAction::None);
+	TestTrue(TEXT("Post match runs out"), Rules.HandleEvent(EMatchEvent::TimerExpired) == EMatchAction::ResetMatch);
+
+	TestTrue(TEXT("Waiting again"), Rules.GetState() == ERulesState::WaitingToStart);
+	TestTrue(TEXT("Outcome is cleared"), Rules.GetOutcome() == ERulesOutcome::None);
+	TestEqual(TEXT("No ejection"), Rules.GetEjectedPlayer(), INDEX_NONE);
+	TestEqual(TEXT("Ejections are cleared"), Rules.GetNumEjections(), 0);
+	TestEqual(TEXT("Players are added again by the owner"), Rules.GetNumSlots(), 0);
+	TestEqual(TEXT("Nobody connected"), Rules.GetNumConnectedPlayers(), 0);
+	TestEqual(TEXT("No innocents counted"), Rules.GetInnocentHeadCount().Alive, 0);
+	TestEqual(TEXT("No killers counted"), Rules.GetKillerHeadCount().Alive, 0);
+
+	// the same rules run the next match from scratch
+	FCast NextCast;
+	TestTrue(TEXT("The next match starts"), StartMatch(*this, Rules, 4, NextCast));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMMatchRulesSlotsTest, "PuppetMaster.MatchRules.Slots", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMMatchRulesSlotsTest::RunTest(const FString& Parameters)
+{
+	using namespace PMMatchRulesTests;
+
+	FPMMatchRules Rules(MakeConfig(), 3);
+
+	// players coming and going in the lobby keep handing the same slots around
+	const int32 Host = Rules.AddPlayer();
+	Rules.SetReady(Host, true);
+	for (int32 Round = 0; Round < 2 * FPMMatchRules::MaxSlots; ++Round)
+	{
+		const int32 Guest = Rules.AddPlayer();
+		if (!TestEqual(TEXT("The guest gets the slot the last one left"), Guest, 1))
+		{
+			return false;
+		}
+		TestTrue(TEXT("A reused slot starts unready"), Rules.GetStatus(Guest) == ERulesSlotStatus::NotReady);
+		TestEqual(TEXT("A reused slot starts with full health"), Rules.GetHealth(Guest), Rules.GetConfig().HealthMax);
+		Rules.SetReady(Guest, true);
+		Rules.RemovePlayer(Guest);
+	}
+	TestEqual(TEXT("Lobby churn doesn't add up"), Rules.GetNumSlots(), 2);
+	TestEqual(TEXT("Only the host is connected"), Rules.GetNumConnectedPlayers(), 1);
+	TestTrue(TEXT("The host is still ready"), Rules.GetStatus(Host) == ERulesSlotStatus::Ready);
+
+	// once slots run out the rules turn players away instead of overflowing the byte they travel in
+	while (Rules.GetNumSlots() < FPMMatchRules::MaxSlots)
+	{
+		Rules.AddPlayer();
+	}
+	TestEqual(TEXT("The free slot was taken first"), Rules.GetNumConnectedPlayers(), FPMMatchRules::MaxSlots);
+	TestEqual(TEXT("Full"), Rules.AddPlayer(), INDEX_NONE);
+	TestEqual(TEXT("Refusing adds no slot"), Rules.GetNumSlots(), FPMMatchRules::MaxSlots);
+	TestEqual(TEXT("Refusing connects nobody"), Rules.GetNumConnectedPlayers(), FPMMatchRules::MaxSlots);
+
+	Rules.RemovePlayer(Host);
+	TestEqual(TEXT("Leaving the lobby makes room"), Rules.AddPlayer(), Host);
+
+	// once the match started a slot stays with whoever had it
+	FPMMatchRules Started(MakeConfig(), 3);
+	FCast Cast;
+	if (!StartMatch(*this, Started, 3, Cast))
+	{
+		return false;
+	}
+	Started.RemovePlayer(Cast.Innocents[0]);
+	TestEqual(TEXT("Joining mid match takes a new slot"), Started.AddPlayer(), 3);
+	TestTrue(TEXT("The slot of whoever left stays theirs"), Started.GetStatus(Cast.Innocents[0]) == ERulesSlotStatus::Disconnected);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
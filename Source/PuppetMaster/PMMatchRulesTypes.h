@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * What FPMMatchRules decides in, kept free of reflection so the rules build and run without the engine.
+ * The reflected enums blueprints and replication see mirror these value for value, see PMMatchTypes.h.
+ */
+
+enum class ERulesState : uint8
+{
+	WaitingToStart,
+	Investigation,
+	Discussion,
+	Voting,
+	Deliberation,
+	PostMatch
+};
+
+enum class ERulesOutcome : uint8
+{
+	None,
+	InnocentsWin,
+	KillersWin
+};
+
+/** Where the player in a slot stands. Slots of players who left stay Disconnected until the slot is reused. */
+enum class ERulesSlotStatus : uint8
+{
+	NotReady,
+	Ready,
+	Alive,
+	Dead,
+	Disconnected
+};
+
+/** Everything that can move the match from one state to another, see FPMMatchRules::HandleEvent. */
+enum class EMatchEvent : uint8
+{
+	PlayersReady,
+	PlayersNotReady,
+	TimerExpired,
+	MeetingCalled,
+	BodyReported,
+	PlayersVoted
+};
+
+const TCHAR* LexToString(EMatchEvent Event);
+
+/** What the owner of the rules has to carry out after an event, see FPMMatchRules::HandleEvent. */
+enum class EMatchAction : uint8
+{
+	None,
+	StartCountdown,
+	CancelCountdown,
+	StartMatch,
+	EnterDiscussion,
+	EnterVoting,
+	EnterDeliberation,
+	ResumeInvestigation,
+	EndMatch,
+	ResetMatch
+};
+
+enum class EHitOutcome : uint8
+{
+	None,
+	PassedOut,
+	Died
+};
+
+/** How many players of one role are in which shape. Alive includes the incapacitated, who can still be revived. */
+struct FPMHeadCount
+{
+	int32 Alive = 0;
+	int32 Incapacitated = 0;
+	int32 Dead = 0;
+
+	int32 GetStanding() const { return Alive - Incapacitated; }
+};
@@ -0,0 +1,131 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMMatchRulesTypes.h"
+
+#include "CoreMinimal.h"
+
+#include "PMMatchTypes.generated.h"
+
+class APMPlayerState;
+
+UENUM(BlueprintType)
+enum class EMatchState : uint8
+{
+	WaitingToStart,
+	Investigation,
+	Discussion,
+	Voting,
+	Deliberation,
+	PostMatch
+};
+
+UENUM(BlueprintType)
+enum class EMatchOutcome : uint8
+{
+	None,
+	InnocentsWin,
+	KillersWin
+};
+
+UENUM(BlueprintType)
+enum class EPlayerMatchStatus : uint8
+{
+	NotReady,
+	Ready,
+	Alive,
+	Dead,
+	Disconnected
+};
+
+/** The reflected enums mirror the rules' own, so the match carries out what the rules decide with a cast. */
+static_assert(static_cast<uint8>(EMatchState::WaitingToStart) == static_cast<uint8>(ERulesState::WaitingToStart), "EMatchState mirrors ERulesState");
+static_assert(static_cast<uint8>(EMatchState::Investigation) == static_cast<uint8>(ERulesState::Investigation), "EMatchState mirrors ERulesState");
+static_assert(static_cast<uint8>(EMatchState::Discussion) == static_cast<uint8>(ERulesState::Discussion), "EMatchState mirrors ERulesState");
+static_assert(static_cast<uint8>(EMatchState::Voting) == static_cast<uint8>(ERulesState::Voting), "EMatchState mirrors ERulesState");
+static_assert(static_cast<uint8>(EMatchState::Deliberation) == static_cast<uint8>(ERulesState::Deliberation), "EMatchState mirrors ERulesState");
+static_assert(static_cast<uint8>(EMatchState::PostMatch) == static_cast<uint8>(ERulesState::PostMatch), "EMatchState mirrors ERulesState");
+
+static_assert(static_cast<uint8>(EMatchOutcome::None) == static_cast<uint8>(ERulesOutcome::None), "EMatchOutcome mirrors ERulesOutcome");
+static_assert(static_cast<uint8>(EMatchOutcome::InnocentsWin) == static_cast<uint8>(ERulesOutcome::InnocentsWin), "EMatchOutcome mirrors ERulesOutcome");
+static_assert(static_cast<uint8>(EMatchOutcome::KillersWin) == static_cast<uint8>(ERulesOutcome::KillersWin), "EMatchOutcome mirrors ERulesOutcome");
+
+static_assert(static_cast<uint8>(EPlayerMatchStatus::NotReady) == static_cast<uint8>(ERulesSlotStatus::NotReady), "EPlayerMatchStatus mirrors ERulesSlotStatus");
+static_assert(static_cast<uint8>(EPlayerMatchStatus::Ready) == static_cast<uint8>(ERulesSlotStatus::Ready), "EPlayerMatchStatus mirrors ERulesSlotStatus");
+static_assert(static_cast<uint8>(EPlayerMatchStatus::Alive) == static_cast<uint8>(ERulesSlotStatus::Alive), "EPlayerMatchStatus mirrors ERulesSlotStatus");
+static_assert(static_cast<uint8>(EPlayerMatchStatus::Dead) == static_cast<uint8>(ERulesSlotStatus::Dead), "EPlayerMatchStatus mirrors ERulesSlotStatus");
+static_assert(static_cast<uint8>(EPlayerMatchStatus::Disconnected) == static_cast<uint8>(ERulesSlotStatus::Disconnected), "EPlayerMatchStatus mirrors ERulesSlotStatus");
+
+inline EMatchState ToMatchState(ERulesState State) { return static_cast<EMatchState>(State); }
+inline EMatchOutcome ToMatchOutcome(ERulesOutcome Outcome) { return static_cast<EMatchOutcome>(Outcome); }
+inline EPlayerMatchStatus ToPlayerMatchStatus(ERulesSlotStatus Status) { return static_cast<EPlayerMatchStatus>(Status); }
+
+UENUM(BlueprintType)
+enum class EPlayerVoteStatus : uint8
+{
+	NoVote,
+	Voted,
+};
+
+/** What clients learn about a match once it is over, sent in one go rather than trickled out as properties. */
+USTRUCT(BlueprintType)
+struct FPMMatchSummary
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	EMatchOutcome Outcome = EMatchOutcome::None;
+
+	/** Roles stay secret until the end. Killers who left before it aren't listed. */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<APMPlayerState*> Killers;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Length = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	uint8 NumKills = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	uint8 NumEjections = 0;
+};
+
+/**
+ * What a reconnecting player needs to see of their match right away, sent in one go rather than waiting for the
+ * match, its vote tracker and every player state to replicate again. Slots are the ones of the match's rules.
+ */
+USTRUCT(BlueprintType)
+struct FPMMatchSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	EMatchState MatchState = EMatchState::WaitingToStart;
+
+	UPROPERTY(BlueprintReadOnly)
+	float ServerTimerEnd = 0.f;
+
+	/** By slot, Disconnected for players who left or haven't come back yet. */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<EPlayerMatchStatus> Statuses;
+
+	/** By slot, whether the player has voted this round. */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<bool> Voted;
+
+	/** By slot, who the player voted for once votes are revealed, INDEX_NONE for a skip or while voting is open. */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> Votes;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPMMatchSnapshot> : public TStructOpsTypeTraitsBase2<FPMMatchSnapshot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMNetSerialization.h"
+
+FVector2D PMNetSerialization::QuantizePlanar(const FVector2D& Location)
+{
+	return FVector2D(FMath::RoundToFloat(Location.X), FMath::RoundToFloat(Location.Y));
+}
+
+void PMNetSerialization::SerializeSignedPacked(FArchive& Ar, int32& Value)
+{
+	uint32 Packed = (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	Ar.SerializeIntPacked(Packed);
+	Value = static_cast<int32>(Packed >> 1) ^ -static_cast<int32>(Packed & 1);
+}
+
+void PMNetSerialization::SerializePlanarLocation(FArchive& Ar, FVector2D& Location)
+{
+	int32 X = FMath::RoundToInt(Location.X);
+	int32 Y = FMath::RoundToInt(Location.Y);
+	SerializeSignedPacked(Ar, X);
+	SerializeSignedPacked(Ar, Y);
+
+	if (Ar.IsLoading())
+	{
+		Location = FVector2D(X, Y);
+	}
+}
@@ -0,0 +1,17 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Helpers for the hand written net serializers. Movement is planar, so locations only ever send X and Y. */
+namespace PMNetSerialization
+{
+	/** Rounds to whole units, the precision planar locations are sent at. */
+	FVector2D QuantizePlanar(const FVector2D& Location);
+
+	/** Zigzag encoded so small negative values stay as small on the wire as small positive ones. */
+	void SerializeSignedPacked(FArchive& Ar, int32& Value);
+
+	void SerializePlanarLocation(FArchive& Ar, FVector2D& Location);
+}
@@ -0,0 +1,253 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMOccluderSubsystem.h"
+
+#include "PuppetMaster.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+void UPMOccluderSubsystem::Deinitialize()
+{
+	InvalidateOccluders();
+
+	Super::Deinitialize();
+}
+
+template<typename FunctorType>
+void UPMOccluderSubsystem::ForEachSegmentInCell(int32 X, int32 Y, FunctorType&& Visit)
+{
+	const int32 CellIndex = Y * NumCellsX + X;
+	for (int32 i = CellStarts[CellIndex]; i < CellStarts[CellIndex + 1]; ++i)
+	{
+		const int32 SegmentIndex = CellSegments[i];
+		if (SegmentStamps[SegmentIndex] != QueryStamp)
+		{
+			SegmentStamps[SegmentIndex] = QueryStamp;
+			if (!Visit(Segments[SegmentIndex]))
+			{
+				return;
+			}
+		}
+	}
+}
+
+void UPMOccluderSubsystem::GatherSegments(const FVector& Origin, float Radius, TArray<FPMWallSegment>& OutSegments)
+{
+	if (!bBuilt)
+	{
+		BuildOccluders(Origin.Z);
+	}
+
+	const FVector2D Origin2D(Origin);
+	const FIntPoint MinCell = GetCell(Origin2D - FVector2D(Radius, Radius));
+	const FIntPoint MaxCell = GetCell(Origin2D + FVector2D(Radius, Radius));
+
+	++QueryStamp;
+
+	OutSegments.Reset();
+	for (int32 Y = FMath::Max(MinCell.Y, 0); Y <= FMath::Min(MaxCell.Y, NumCellsY - 1); ++Y)
+	{
+		for (int32 X = FMath::Max(MinCell.X, 0); X <= FMath::Min(MaxCell.X, NumCellsX - 1); ++X)
+		{
+			ForEachSegmentInCell(X, Y, [&](const FPMWallSegment& Segment)
+			{
+				if (PMVisibility::DistanceToSegment(Origin2D, Segment) < Radius)
+				{
+					OutSegments.Add(Segment);
+				}
+				return true;
+			});
+		}
+	}
+}
+
+bool UPMOccluderSubsystem::HasLineOfSight(const FVector& From, const FVector& To)
+{
+	if (!bBuilt)
+	{
+		BuildOccluders(From.Z);
+	}
+
+	const FVector2D Start(From);
+	const FVector2D End(To);
+
+	++QueryStamp;
+
+	// walk the cells the line passes through (Amanatides & Woo)
+	const FVector2D GridStart = (Start - GridOrigin) / CellSize;
+	const FVector2D GridEnd = (End - GridOrigin) / CellSize;
+	const FVector2D Direction = GridEnd - GridStart;
+
+	FIntPoint Cell = GetCell(Start);
+	const FIntPoint EndCell = GetCell(End);
+
+	const int32 StepX = (Direction.X > 0.f) ? 1 : -1;
+	const int32 StepY = (Direction.Y > 0.f) ? 1 : -1;
+
+	const float DeltaX = FMath::IsNearlyZero(Direction.X) ? MAX_flt : FMath::Abs(1.f / Direction.X);
+	const float DeltaY = FMath::IsNearlyZero(Direction.Y) ? MAX_flt : FMath::Abs(1.f / Direction.Y);
+
+	float NextX = FMath::IsNearlyZero(Direction.X) ? MAX_flt : ((Cell.X + (StepX > 0 ? 1 : 0)) - GridStart.X) / Direction.X;
+	float NextY = FMath::IsNearlyZero(Direction.Y) ? MAX_flt : ((Cell.Y + (StepY > 0 ? 1 : 0)) - GridStart.Y) / Direction.Y;
+
+	bool bBlocked = false;
+	const int32 NumSteps = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y);
+	for (int32 Step = 0; (Step <= NumSteps) && !bBlocked; ++Step)
+	{
+		if (IsValidCell(Cell.X, Cell.Y))
+		{
+			ForEachSegmentInCell(Cell.X, Cell.Y, [&](const FPMWallSegment& Segment)
+			{
+				bBlocked = PMVisibility::SegmentsIntersect(Start, End, Segment.Start, Segment.End);
+				return !bBlocked;
+			});
+		}
+
+		if (NextX < NextY)
+		{
+			NextX += DeltaX;
+			Cell.X += StepX;
+		}
+		else
+		{
+			NextY += DeltaY;
+			Cell.Y += StepY;
+		}
+	}
+
+	return !bBlocked;
+}
+
+void UPMOccluderSubsystem::InvalidateOccluders()
+{
+	Segments.Reset();
+	CellStarts.Reset();
+	CellSegments.Reset();
+	SegmentStamps.Reset();
+	NumCellsX = 0;
+	NumCellsY = 0;
+	bBuilt = false;
+}
+
+void UPMOccluderSubsystem::BuildOccluders(float PlaneHeight)
+{
+	Segments.Reset();
+	bBuilt = true;
+
+	UWorld& World = *GetWorld();
+	for (TActorIterator<AActor> It(&World); It; ++It)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(*It);
+		for (const UPrimitiveComponent* Primitive : Primitives)
+		{
+			// only level geometry occludes, puppets and bodies never do
+			if ((Primitive->Mobility != EComponentMobility::Static) || !Primitive->IsQueryCollisionEnabled() || (Primitive->GetCollisionResponseToChannel(ECC_Visibility) != ECR_Block))
+			{
+				continue;
+			}
+
+			// skip floors and anything else that doesn't cut through the plane puppets see in
+			const FBox WorldBox = Primitive->Bounds.GetBox();
+			if ((PlaneHeight < WorldBox.Min.Z) || (PlaneHeight > WorldBox.Max.Z))
+			{
+				continue;
+			}
+
+			FVector Corners[4];
+
+			const UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Primitive);
+			if (MeshComponent && MeshComponent->GetStaticMesh())
+			{
+				// rotated walls keep their footprint rather than growing to their world aligned bounds
+				const FBox LocalBox = MeshComponent->GetStaticMesh()->GetBoundingBox();
+				const FTransform& Transform = MeshComponent->GetComponentTransform();
+				Corners[0] = Transform.TransformPosition(FVector(LocalBox.Min.X, LocalBox.Min.Y, 0.f));
+				Corners[1] = Transform.TransformPosition(FVector(LocalBox.Max.X, LocalBox.Min.Y, 0.f));
+				Corners[2] = Transform.TransformPosition(FVector(LocalBox.Max.X, LocalBox.Max.Y, 0.f));
+				Corners[3] = Transform.TransformPosition(FVector(LocalBox.Min.X, LocalBox.Max.Y, 0.f));
+			}
+			else
+			{
+				Corners[0] = FVector(WorldBox.Min.X, WorldBox.Min.Y, 0.f);
+				Corners[1] = FVector(WorldBox.Max.X, WorldBox.Min.Y, 0.f);
+				Corners[2] = FVector(WorldBox.Max.X, WorldBox.Max.Y, 0.f);
+				Corners[3] = FVector(WorldBox.Min.X, WorldBox.Max.Y, 0.f);
+			}
+
+			for (int32 i = 0; i < 4; ++i)
+			{
+				Segments.Emplace(FVector2D(Corners[i]), FVector2D(Corners[(i + 1) % 4]));
+			}
+		}
+	}
+
+	BuildGrid();
+
+	UE_LOG(LogPuppetMaster, Log, TEXT("Extracted %d occluder segments at height %.1f into a %dx%d grid"), Segments.Num(), PlaneHeight, NumCellsX, NumCellsY);
+}
+
+void UPMOccluderSubsystem::BuildGrid()
+{
+	check(CellSize > 0.f);
+
+	FBox2D Bounds(ForceInit);
+	for (const FPMWallSegment& Segment : Segments)
+	{
+		Bounds += Segment.Start;
+		Bounds += Segment.End;
+	}
+
+	if (!Bounds.bIsValid)
+	{
+		Bounds = FBox2D(FVector2D::ZeroVector, FVector2D::ZeroVector);
+	}
+
+	GridOrigin = Bounds.Min;
+	NumCellsX = FMath::FloorToInt(Bounds.GetSize().X / CellSize) + 1;
+	NumCellsY = FMath::FloorToInt(Bounds.GetSize().Y / CellSize) + 1;
+
+	// counting pass then fill pass, so every cell's segments end up contiguous
+	auto ForEachCellOfSegment = [this](const FPMWallSegment& Segment, const TFunctionRef<void(int32 CellIndex)>& Func)
+	{
+		const FIntPoint MinCell = GetCell(FVector2D(FMath::Min(Segment.Start.X, Segment.End.X), FMath::Min(Segment.Start.Y, Segment.End.Y)));
+		const FIntPoint MaxCell = GetCell(FVector2D(FMath::Max(Segment.Start.X, Segment.End.X), FMath::Max(Segment.Start.Y, Segment.End.Y)));
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				Func(Y * NumCellsX + X);
+			}
+		}
+	};
+
+	CellStarts.Init(0, NumCellsX * NumCellsY + 1);
+	for (const FPMWallSegment& Segment : Segments)
+	{
+		ForEachCellOfSegment(Segment, [this](int32 CellIndex) { ++CellStarts[CellIndex + 1]; });
+	}
+
+	for (int32 CellIndex = 1; CellIndex < CellStarts.Num(); ++CellIndex)
+	{
+		CellStarts[CellIndex] += CellStarts[CellIndex - 1];
+	}
+
+	TArray<int32> CellFill(CellStarts);
+	CellSegments.SetNumUninitialized(CellStarts.Last());
+	for (int32 SegmentIndex = 0; SegmentIndex < Segments.Num(); ++SegmentIndex)
+	{
+		ForEachCellOfSegment(Segments[SegmentIndex], [this, &CellFill, SegmentIndex](int32 CellIndex) { CellSegments[CellFill[CellIndex]++] = SegmentIndex; });
+	}
+
+	SegmentStamps.Init(0, Segments.Num());
+	QueryStamp = 0;
+}
+
+FIntPoint UPMOccluderSubsystem::GetCell(const FVector2D& Location) const
+{
+	const FVector2D Local = (Location - GridOrigin) / CellSize;
+	return FIntPoint(FMath::FloorToInt(Local.X), FMath::FloorToInt(Local.Y));
+}
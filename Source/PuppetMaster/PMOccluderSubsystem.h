@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMVisibility.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PMOccluderSubsystem.generated.h"
+
+/**
+ * Owns the wall segments line of sight is computed against.
+ * The map is planar, so static geometry that blocks visibility is flattened into 2D segments once and cached,
+ * then bucketed into a uniform grid so queries only touch the walls near them.
+ */
+UCLASS(config = Game)
+class UPMOccluderSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	void Deinitialize() override;
+
+	/** Gathers the segments within Radius of Origin, extracting them from the level on first use. */
+	void GatherSegments(const FVector& Origin, float Radius, TArray<FPMWallSegment>& OutSegments);
+
+	/** True if no wall crosses the line between the two points. Only walks the grid cells the line passes through. */
+	bool HasLineOfSight(const FVector& From, const FVector& To);
+
+	/** Throws away the cached segments, e.g. after level geometry has been streamed in or out. */
+	void InvalidateOccluders();
+
+	int32 GetNumSegments() const { return Segments.Num(); }
+
+private:
+
+	void BuildOccluders(float PlaneHeight);
+	void BuildGrid();
+
+	FIntPoint GetCell(const FVector2D& Location) const;
+	bool IsValidCell(int32 X, int32 Y) const { return (X >= 0) && (Y >= 0) && (X < NumCellsX) && (Y < NumCellsY); }
+
+	/** Calls Visit once for every segment registered in the cell, skipping those already visited by this query. */
+	template<typename FunctorType>
+	void ForEachSegmentInCell(int32 X, int32 Y, FunctorType&& Visit);
+
+	TArray<FPMWallSegment> Segments;
+
+	bool bBuilt = false;
+
+	/** Grid cells are stored flat; the segments of cell i are CellSegments[CellStarts[i] .. CellStarts[i + 1]). */
+	TArray<int32> CellStarts;
+	TArray<int32> CellSegments;
+
+	FVector2D GridOrigin = FVector2D::ZeroVector;
+	int32 NumCellsX = 0;
+	int32 NumCellsY = 0;
+
+	/** Segments can span several cells, stamps make sure each is tested once per query. */
+	TArray<uint32> SegmentStamps;
+	uint32 QueryStamp = 0;
+
+	UPROPERTY(config)
+	float CellSize = 400.f;
+
+};
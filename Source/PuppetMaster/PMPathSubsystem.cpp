@@ -0,0 +1,261 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMPathSubsystem.h"
+
+#include "PuppetMaster.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Find Path"), STAT_PMFindPath, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Update Path Goal"), STAT_PMUpdatePathGoal, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Cache Hits"), STAT_PMPathCacheHits, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Cache Misses"), STAT_PMPathCacheMisses, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Shared"), STAT_PMPathQueriesShared, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Goal Updates"), STAT_PMPathGoalUpdates, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Queries In Flight"), STAT_PMPathQueriesInFlight, STATGROUP_PuppetMaster);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Paths"), STAT_PMCachedPaths, STATGROUP_PuppetMaster);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Cache Hit Rate (%)"), STAT_PMPathCacheHitRate, STATGROUP_PuppetMaster);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Query Time (ms)"), STAT_PMPathQueryTime, STATGROUP_PuppetMaster);
+
+void UPMPathSubsystem::Deinitialize()
+{
+	if (NumHits + NumMisses > 0)
+	{
+		UE_LOG(LogPuppetMaster, Log, TEXT("Path cache: %d hits, %d misses (%.1f%% hit rate), %d shared queries, %d goal updates, %.2f ms average query"),
+			NumHits, NumMisses, 100.f * NumHits / (NumHits + NumMisses), NumSharedQueries, NumGoalUpdates, NumQueries > 0 ? TotalQueryMs / NumQueries : 0.0);
+	}
+
+	FlushCache();
+	PendingQueries.Empty();
+
+	Super::Deinitialize();
+}
+
+void UPMPathSubsystem::FindPath(const AController& Requester, const FVector& Goal, const FPMPathReady& OnReady)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMFindPath);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetNavDataForProps(Requester.GetNavAgentPropertiesRef()) : nullptr;
+	if (!NavData)
+	{
+		OnReady.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	if (!bBoundToNavigation)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UPMPathSubsystem::OnNavigationGenerated);
+		bBoundToNavigation = true;
+	}
+
+	FNavLocation StartLocation;
+	FNavLocation GoalLocation;
+	const FVector Extent = NavData->GetDefaultQueryExtent();
+	if (!NavData->ProjectPoint(Requester.GetNavAgentLocation(), StartLocation, Extent, NavData->GetDefaultQueryFilter(), &Requester)
+		|| !NavData->ProjectPoint(Goal, GoalLocation, Extent, NavData->GetDefaultQueryFilter(), &Requester))
+	{
+		OnReady.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	const FPathKey Key = MakeKey(StartLocation, GoalLocation);
+
+	if (const FCachedPath* Cached = Cache.Find(Key))
+	{
+		if (GetWorld()->GetTimeSeconds() - Cached->Time < CacheLifetime)
+		{
+			++NumHits;
+			INC_DWORD_STAT(STAT_PMPathCacheHits);
+			UpdateStats();
+
+			OnReady.ExecuteIfBound(MakePath(*NavData, *Cached, StartLocation.Location, GoalLocation.Location));
+			return;
+		}
+
+		Cache.Remove(Key);
+	}
+
+	++NumMisses;
+	INC_DWORD_STAT(STAT_PMPathCacheMisses);
+
+	// someone else is already on their way from and to the same spots
+	if (FPendingQuery* Pending = PendingQueries.Find(Key))
+	{
+		++NumSharedQueries;
+		INC_DWORD_STAT(STAT_PMPathQueriesShared);
+
+		Pending->Waiters.Add({ StartLocation.Location, GoalLocation.Location, OnReady });
+		UpdateStats();
+		return;
+	}
+
+	const FPathFindingQuery Query(&Requester, *NavData, StartLocation.Location, GoalLocation.Location, NavData->GetDefaultQueryFilter());
+	const uint32 QueryID = NavSys->FindPathAsync(Requester.GetNavAgentPropertiesRef(), Query, FNavPathQueryDelegate::CreateUObject(this, &UPMPathSubsystem::OnQueryFinished, Key));
+	if (QueryID == INVALID_NAVQUERYID)
+	{
+		OnReady.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	FPendingQuery& NewQuery = PendingQueries.Add(Key);
+	NewQuery.StartTime = FPlatformTime::Seconds();
+	NewQuery.Waiters.Add({ StartLocation.Location, GoalLocation.Location, OnReady });
+	UpdateStats();
+}
+
+bool UPMPathSubsystem::TryUpdatePathGoal(const AController& Requester, FNavigationPath& Path, const FVector& NewGoal)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMUpdatePathGoal);
+
+	const ANavigationData* NavData = Path.GetNavigationDataUsed();
+	TArray<FNavPathPoint>& Points = Path.GetPathPoints();
+	if (!NavData || Path.IsPartial() || (Points.Num() < 2))
+	{
+		return false;
+	}
+
+	FNavLocation GoalLocation;
+	if (!NavData->ProjectPoint(NewGoal, GoalLocation, NavData->GetDefaultQueryExtent(), NavData->GetDefaultQueryFilter(), &Requester))
+	{
+		return false;
+	}
+
+	// raycasts return true when they hit the edge of the navmesh
+	FVector HitLocation;
+	const FNavPathPoint& LastCorner = Points[Points.Num() - 2];
+	if (!NavData->Raycast(LastCorner.Location, GoalLocation.Location, HitLocation, NavData->GetDefaultQueryFilter(), &Requester))
+	{
+		Points.Last() = FNavPathPoint(GoalLocation.Location, GoalLocation.NodeRef);
+	}
+	else if ((FVector::Dist(Points.Last().Location, GoalLocation.Location) < MaxGoalExtension)
+		&& !NavData->Raycast(Points.Last().Location, GoalLocation.Location, HitLocation, NavData->GetDefaultQueryFilter(), &Requester))
+	{
+		Points.Add(FNavPathPoint(GoalLocation.Location, GoalLocation.NodeRef));
+	}
+	else
+	{
+		return false;
+	}
+
+	++NumGoalUpdates;
+	INC_DWORD_STAT(STAT_PMPathGoalUpdates);
+
+	// lets path following pick the path back up without finishing the move request
+	Path.DoneUpdating(ENavPathUpdateType::GoalMoved);
+	return true;
+}
+
+void UPMPathSubsystem::FlushCache()
+{
+	Cache.Empty();
+	UpdateStats();
+}
+
+UPMPathSubsystem::FPathKey UPMPathSubsystem::MakeKey(const FNavLocation& Start, const FNavLocation& Goal) const
+{
+	FPathKey Key;
+	Key.StartPoly = Start.NodeRef;
+	Key.GoalPoly = Goal.NodeRef;
+	Key.StartCell = FIntPoint(FMath::FloorToInt(Start.Location.X / CacheCellSize), FMath::FloorToInt(Start.Location.Y / CacheCellSize));
+	Key.GoalCell = FIntPoint(FMath::FloorToInt(Goal.Location.X / CacheCellSize), FMath::FloorToInt(Goal.Location.Y / CacheCellSize));
+	return Key;
+}
+
+FNavPathSharedPtr UPMPathSubsystem::MakePath(const ANavigationData& NavData, const FCachedPath& Cached, const FVector& Start, const FVector& Goal) const
+{
+	FNavPathSharedPtr Path = MakeShared<FNavigationPath, ESPMode::ThreadSafe>();
+	Path->GetPathPoints() = Cached.Points;
+
+	// the cached path may have been found between other points of the same cells
+	Path->GetPathPoints()[0].Location = Start;
+	if (!Cached.bPartial)
+	{
+		Path->GetPathPoints().Last().Location = Goal;
+	}
+
+	Path->SetNavigationDataUsed(&NavData);
+	Path->SetIsPartial(Cached.bPartial);
+	Path->MarkReady();
+	return Path;
+}
+
+void UPMPathSubsystem::AddToCache(const FPathKey& Key, const FCachedPath& Entry)
+{
+	if (Cache.Num() >= MaxCachedPaths)
+	{
+		const float Now = GetWorld()->GetTimeSeconds();
+		for (auto It = Cache.CreateIterator(); It; ++It)
+		{
+			if (Now - It.Value().Time >= CacheLifetime)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	if (Cache.Num() >= MaxCachedPaths)
+	{
+		FPathKey OldestKey;
+		float OldestTime = MAX_flt;
+		for (const TPair<FPathKey, FCachedPath>& Cached : Cache)
+		{
+			if (Cached.Value.Time < OldestTime)
+			{
+				OldestKey = Cached.Key;
+				OldestTime = Cached.Value.Time;
+			}
+		}
+		Cache.Remove(OldestKey);
+	}
+
+	Cache.Add(Key, Entry);
+}
+
+void UPMPathSubsystem::OnQueryFinished(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path, FPathKey Key)
+{
+	FPendingQuery Pending;
+	if (!PendingQueries.RemoveAndCopyValue(Key, Pending))
+	{
+		// flushed while in flight
+		return;
+	}
+
+	++NumQueries;
+	TotalQueryMs += (FPlatformTime::Seconds() - Pending.StartTime) * 1000.0;
+
+	const bool bFound = (Result == ENavigationQueryResult::Success) && Path.IsValid() && Path->IsValid();
+	const ANavigationData* NavData = bFound ? Path->GetNavigationDataUsed() : nullptr;
+
+	FCachedPath Entry;
+	if (bFound && NavData)
+	{
+		Entry.Points = Path->GetPathPoints();
+		Entry.bPartial = Path->IsPartial();
+		Entry.Time = GetWorld()->GetTimeSeconds();
+		AddToCache(Key, Entry);
+	}
+
+	UpdateStats();
+
+	// waiters are free to ask for more paths from here
+	for (const FWaiter& Waiter : Pending.Waiters)
+	{
+		Waiter.OnReady.ExecuteIfBound(NavData ? MakePath(*NavData, Entry, Waiter.Start, Waiter.Goal) : nullptr);
+	}
+}
+
+void UPMPathSubsystem::UpdateStats()
+{
+	SET_DWORD_STAT(STAT_PMPathQueriesInFlight, PendingQueries.Num());
+	SET_DWORD_STAT(STAT_PMCachedPaths, Cache.Num());
+	SET_FLOAT_STAT(STAT_PMPathCacheHitRate, (NumHits + NumMisses) > 0 ? 100.f * NumHits / (NumHits + NumMisses) : 0.f);
+	SET_FLOAT_STAT(STAT_PMPathQueryTime, NumQueries > 0 ? TotalQueryMs / NumQueries : 0.0);
+}
+
+void UPMPathSubsystem::OnNavigationGenerated(ANavigationData* NavData)
+{
+	FlushCache();
+}
@@ -0,0 +1,125 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "AI/Navigation/NavigationTypes.h"
+#include "NavigationData.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PMPathSubsystem.generated.h"
+
+class AController;
+class UNavigationSystemV1;
+
+/** Gets a path of its own, or null if there is no way to the goal. */
+DECLARE_DELEGATE_OneParam(FPMPathReady, FNavPathSharedPtr /*Path*/);
+
+/**
+ * Finds paths for puppets without stalling the game thread.
+ * Queries run on the navigation system's async path finding. Results are cached by the navmesh polys and the
+ * quantized locations they start and end at, so puppets clicking around the same rooms mostly share paths, and
+ * identical queries in flight at the same time are only run once.
+ */
+UCLASS(config = Game)
+class UPMPathSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	void Deinitialize() override;
+
+	/** Finds a path for the pawn of Requester to Goal. OnReady may be called before this returns. */
+	void FindPath(const AController& Requester, const FVector& Goal, const FPMPathReady& OnReady);
+
+	/**
+	 * Moves the end of Path to NewGoal without a query when the new goal can be walked to straight from the path's
+	 * last corner or from its old goal. Returns false if Path needs to be found again.
+	 */
+	bool TryUpdatePathGoal(const AController& Requester, FNavigationPath& Path, const FVector& NewGoal);
+
+	/** Throws away every cached path, e.g. after the navmesh has been rebuilt. */
+	void FlushCache();
+
+private:
+
+	struct FPathKey
+	{
+		NavNodeRef StartPoly = INVALID_NAVNODEREF;
+		NavNodeRef GoalPoly = INVALID_NAVNODEREF;
+		FIntPoint StartCell = FIntPoint::ZeroValue;
+		FIntPoint GoalCell = FIntPoint::ZeroValue;
+
+		bool operator==(const FPathKey& Other) const
+		{
+			return (StartPoly == Other.StartPoly) && (GoalPoly == Other.GoalPoly) && (StartCell == Other.StartCell) && (GoalCell == Other.GoalCell);
+		}
+
+		friend uint32 GetTypeHash(const FPathKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.StartPoly), GetTypeHash(Key.GoalPoly)), HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.GoalCell)));
+		}
+	};
+
+	struct FCachedPath
+	{
+		TArray<FNavPathPoint> Points;
+		bool bPartial = false;
+		float Time = 0.f;
+	};
+
+	struct FWaiter
+	{
+		FVector Start;
+		FVector Goal;
+		FPMPathReady OnReady;
+	};
+
+	struct FPendingQuery
+	{
+		double StartTime = 0.0;
+		TArray<FWaiter> Waiters;
+	};
+
+	FPathKey MakeKey(const FNavLocation& Start, const FNavLocation& Goal) const;
+
+	/** A copy of Cached that starts and ends exactly where the requester asked for. */
+	FNavPathSharedPtr MakePath(const ANavigationData& NavData, const FCachedPath& Cached, const FVector& Start, const FVector& Goal) const;
+
+	void AddToCache(const FPathKey& Key, const FCachedPath& Entry);
+
+	void OnQueryFinished(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path, FPathKey Key);
+
+	void UpdateStats();
+
+	UFUNCTION()
+	void OnNavigationGenerated(ANavigationData* NavData);
+
+	TMap<FPathKey, FCachedPath> Cache;
+	TMap<FPathKey, FPendingQuery> PendingQueries;
+
+	bool bBoundToNavigation = false;
+
+	int32 NumHits = 0;
+	int32 NumMisses = 0;
+	int32 NumSharedQueries = 0;
+	int32 NumGoalUpdates = 0;
+	int32 NumQueries = 0;
+	double TotalQueryMs = 0.0;
+
+	/** Size of the cells start and goal locations are snapped to within their polys. */
+	UPROPERTY(config)
+	float CacheCellSize = 200.f;
+
+	UPROPERTY(config)
+	int32 MaxCachedPaths = 256;
+
+	/** Seconds a path is reused for, navmesh rebuilds flush the cache regardless. */
+	UPROPERTY(config)
+	float CacheLifetime = 10.f;
+
+	/** How far a goal may move past the end of a path and still be tacked on to it. */
+	UPROPERTY(config)
+	float MaxGoalExtension = 300.f;
+
+};
@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMPlanarMovementComponent.h"
+
+#include "PuppetMaster.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarPlanarMovement(
+	TEXT("pm.PlanarMovement"),
+	1,
+	TEXT("How puppets move.\n")
+	TEXT("0: full character movement, 1: planar path stepping and interpolated proxies (default)"));
+
+DECLARE_CYCLE_STAT(TEXT("Planar Movement"), STAT_PMPlanarMovement, STATGROUP_PuppetMaster);
+DECLARE_CYCLE_STAT(TEXT("Planar Proxy Interpolation"), STAT_PMPlanarInterpolation, STATGROUP_PuppetMaster);
+
+UPMPlanarMovementComponent::UPMPlanarMovementComponent()
+{
+	// nothing is based on or pushed around by puppets
+	bEnablePhysicsInteraction = false;
+	bUseRVOAvoidance = false;
+	bAlwaysCheckFloor = false;
+}
+
+void UPMPlanarMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation)
+{
+	if (CVarPlanarMovement.GetValueOnGameThread() == 0)
+	{
+		Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+		return;
+	}
+
+	if (!HasValidData())
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float TimeSinceLastCorrection = Now - LastCorrectionTime;
+	LastCorrectionTime = Now;
+
+	// spawns and restarts aren't walked to
+	if (FVector::DistSquared(OldLocation, NewLocation) > FMath::Square(MaxInterpolationDistance))
+	{
+		bInterpolating = false;
+		UpdatedComponent->SetWorldLocationAndRotation(NewLocation, NewRotation, false, nullptr, ETeleportType::TeleportPhysics);
+		return;
+	}
+
+	// the proxy is still shown where it was, ease it over about as long as the update took to come in
+	InterpStartLocation = OldLocation;
+	InterpStartRotation = OldRotation;
+	InterpTargetLocation = NewLocation;
+	InterpTargetRotation = NewRotation;
+	InterpStartTime = Now;
+	InterpDuration = FMath::Clamp(TimeSinceLastCorrection, 0.f, MaxInterpolationTime);
+	bInterpolating = true;
+}
+
+void UPMPlanarMovementComponent::PerformMovement(float DeltaSeconds)
+{
+	if (CVarPlanarMovement.GetValueOnGameThread() == 0)
+	{
+		Super::PerformMovement(DeltaSeconds);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PMPlanarMovement);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, PlanarMovement);
+
+	if (!HasValidData() || (DeltaSeconds < MIN_TICK_TIME))
+	{
+		return;
+	}
+
+	// path following asks for a velocity every tick, without one the puppet stands
+	Velocity = bHasRequestedVelocity ? RequestedVelocity.GetClampedToMaxSize2D(GetMaxSpeed()) : FVector::ZeroVector;
+	Velocity.Z = 0.f;
+	bHasRequestedVelocity = false;
+
+	const FQuat OldRotation = UpdatedComponent->GetComponentQuat();
+	FQuat NewRotation = OldRotation;
+	if (bOrientRotationToMovement && !Velocity.IsNearlyZero())
+	{
+		const FRotator CurrentRotation = UpdatedComponent->GetComponentRotation();
+		NewRotation = FMath::RInterpConstantTo(CurrentRotation, Velocity.GetSafeNormal2D().Rotation(), DeltaSeconds, RotationRate.Yaw).Quaternion();
+	}
+
+	const FVector Delta = Velocity * DeltaSeconds;
+	if (!Delta.IsNearlyZero() || !NewRotation.Equals(OldRotation))
+	{
+		FHitResult Hit(1.f);
+		SafeMoveUpdatedComponent(Delta, NewRotation, true, Hit);
+
+		// walls and other puppets are slid along rather than stopped at
+		if (Hit.IsValidBlockingHit())
+		{
+			SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
+		}
+	}
+
+	UpdateComponentVelocity();
+
+	LastUpdateLocation = UpdatedComponent->GetComponentLocation();
+	LastUpdateRotation = UpdatedComponent->GetComponentQuat();
+	LastUpdateVelocity = Velocity;
+}
+
+void UPMPlanarMovementComponent::SimulatedTick(float DeltaSeconds)
+{
+	if (CVarPlanarMovement.GetValueOnGameThread() == 0)
+	{
+		Super::SimulatedTick(DeltaSeconds);
+		return;
+	}
+
+	if (!bInterpolating || !HasValidData())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PMPlanarInterpolation);
+
+	const float Alpha = (InterpDuration > 0.f) ? FMath::Clamp((GetWorld()->GetTimeSeconds() - InterpStartTime) / InterpDuration, 0.f, 1.f) : 1.f;
+	const FVector Location = FMath::Lerp(InterpStartLocation, InterpTargetLocation, Alpha);
+	const FQuat Rotation = FQuat::Slerp(InterpStartRotation, InterpTargetRotation, Alpha);
+
+	UpdatedComponent->SetWorldLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	bInterpolating = (Alpha < 1.f);
+}
@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "GameFramework/CharacterMovementComponent.h"
+
+#include "PMPlanarMovementComponent.generated.h"
+
+/**
+ * Movement for puppets, which only ever walk navmesh paths on a plane and only ever move on the server.
+ * Instead of simulating walking physics the server steps along the velocity path following asks for with a
+ * single capsule sweep, sliding along whatever it hits, and simulated proxies ease from where they are shown to
+ * each update the server sends rather than simulating movement of their own.
+ * It stays a character movement component so ACharacter, path following and blueprints keep working, and so
+ * pm.PlanarMovement 0 can switch back to full character movement to compare the two side by side.
+ */
+UCLASS()
+class UPMPlanarMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UPMPlanarMovementComponent();
+
+	void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation) override;
+
+protected:
+
+	void PerformMovement(float DeltaSeconds) override;
+	void SimulatedTick(float DeltaSeconds) override;
+
+	/** Updates further away than this are snapped to rather than eased into. */
+	UPROPERTY(EditDefaultsOnly, Category = "Planar Movement")
+	float MaxInterpolationDistance = 500.f;
+
+	/** Longest a simulated proxy takes to ease into an update. */
+	UPROPERTY(EditDefaultsOnly, Category = "Planar Movement")
+	float MaxInterpolationTime = 0.25f;
+
+private:
+
+	FVector InterpStartLocation = FVector::ZeroVector;
+	FVector InterpTargetLocation = FVector::ZeroVector;
+	FQuat InterpStartRotation = FQuat::Identity;
+	FQuat InterpTargetRotation = FQuat::Identity;
+	float InterpStartTime = 0.f;
+	float InterpDuration = 0.f;
+	float LastCorrectionTime = 0.f;
+	bool bInterpolating = false;
+
+};
@@ -3,17 +3,60 @@
 #include "PMPlayerController.h"
 
 #include "PMCharacter.h"
+#include "PMGameMode.h"
+#include "PMMatch.h"
+#include "PMNetSerialization.h"
+#include "PuppetMaster.h"
 
+#include "Camera/CameraComponent.h"
 #include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/SpringArmComponent.h"
 #include "Net/UnrealNetwork.h"
 #include "Runtime/Engine/Classes/Components/DecalComponent.h"
 
 DECLARE_LOG_CATEGORY_CLASS(LogPMPlayerController, Warning, All)
 
+DECLARE_CYCLE_STAT(TEXT("Server Move Command"), STAT_PMServerMoveCommand, STATGROUP_PuppetMaster);
+
+namespace
+{
+	/** Wrap around aware, sequences are only 16 bits. */
+	bool IsNewerSequence(uint16 A, uint16 B)
+	{
+		return static_cast<int16>(A - B) > 0;
+	}
+}
+
+bool FPMMoveCommand::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << Sequence;
+
+	uint8 bPackedFollow = bFollow ? 1 : 0;
+	Ar.SerializeBits(&bPackedFollow, 1);
+	bFollow = (bPackedFollow != 0);
+
+	bOutSuccess = true;
+	if (bFollow)
+	{
+		// sent as its net guid
+		UObject* Object = Target;
+		bOutSuccess = Map->SerializeObject(Ar, APMCharacter::StaticClass(), Object);
+		Target = Cast<APMCharacter>(Object);
+
+		Ar << ClientTime;
+	}
+
+	PMNetSerialization::SerializePlanarLocation(Ar, Destination);
+
+	return true;
+}
+
 APMPlayerController::APMPlayerController()
 {
 	bShowMouseCursor = true;
 	DefaultMouseCursor = EMouseCursor::Crosshairs;
+	PlayerCameraManagerClass = APMPlayerCameraManager::StaticClass();
 }
 
 void APMPlayerController::PostInitializeComponents()
@@ -29,7 +72,20 @@ void APMPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>&
 
 	ResetReplicatedLifetimeProperty(StaticClass(), AController::StaticClass(), TEXT("Pawn"), COND_Never, OutLifetimeProps);
 
-	DOREPLIFETIME(APMPlayerController, SimulatedPawn);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMPlayerController, SimulatedPawn, Params);
+
+	Params.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMPlayerController, AckedCommandSequence, Params);
+}
+
+void APMPlayerController::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	PushModelValidator.Validate(*this);
 }
 
 void APMPlayerController::SetSimulatedPawn(APawn* InPawn)
@@ -37,6 +93,13 @@ void APMPlayerController::SetSimulatedPawn(APawn* InPawn)
 	check(!IsValid(InPawn) || InPawn->IsA<APMCharacter>());
 
 	SimulatedPawn = Cast<APMCharacter>(InPawn);
+	PM_MARK_PROPERTY_DIRTY(APMPlayerController, SimulatedPawn);
+
+	// the rig first, so the puppet's view target events find it
+	if (IsLocalController())
+	{
+		AttachCameraRig();
+	}
 
 	if (SimulatedPawn)
 	{
@@ -49,11 +112,67 @@ APawn* APMPlayerController::GetSimulatedPawn() const
 	return SimulatedPawn;
 }
 
+void APMPlayerController::ClientMatchSnapshot_Implementation(const FPMMatchSnapshot& Snapshot)
+{
+	UE_LOG(LogPMPlayerController, Log, TEXT("Match snapshot received %.2fs after joining, %d slots"), GetWorld()->GetRealTimeSeconds(), Snapshot.Statuses.Num());
+
+	// the game state may still be on its way, in which case PlayerTick hands it over
+	PendingSnapshot = Snapshot;
+	bHasPendingSnapshot = true;
+	ShowPendingSnapshot();
+}
+
+void APMPlayerController::ClientReconnectToken_Implementation(const FString& Token)
+{
+	// the local player outlives the connection, the controller doesn't
+	if (UPMLocalPlayer* PMLocalPlayer = Cast<UPMLocalPlayer>(GetLocalPlayer()))
+	{
+		PMLocalPlayer->SetReconnectToken(Token);
+	}
+}
+
+void APMPlayerController::ShowPendingSnapshot()
+{
+	if (APMGameState* PMGameState = GetWorld()->GetGameState<APMGameState>())
+	{
+		PMGameState->ShowSnapshot(PendingSnapshot);
+		bHasPendingSnapshot = false;
+	}
+}
+
 void APMPlayerController::OnRep_SimulatedPawn()
 {
 	SetSimulatedPawn(SimulatedPawn);
 }
 
+void APMPlayerController::AttachCameraRig()
+{
+	if (!CameraBoomComponent)
+	{
+		CameraBoomComponent = NewObject<USpringArmComponent>(this, TEXT("CameraBoom"));
+		CameraBoomComponent->SetUsingAbsoluteRotation(true); // Don't want arm to rotate when character does
+		CameraBoomComponent->TargetArmLength = CameraArmLength;
+		CameraBoomComponent->SetRelativeRotation(FRotator(CameraPitch, 0.f, 0.f));
+		CameraBoomComponent->bDoCollisionTest = false; // Don't want to pull camera in when it collides with level
+		CameraBoomComponent->bEnableCameraLag = true;
+		CameraBoomComponent->RegisterComponent();
+
+		CameraComponent = NewObject<UCameraComponent>(this, TEXT("TopDownCamera"));
+		CameraComponent->SetupAttachment(CameraBoomComponent, USpringArmComponent::SocketName);
+		CameraComponent->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+		CameraComponent->RegisterComponent();
+	}
+
+	if (SimulatedPawn)
+	{
+		CameraBoomComponent->AttachToComponent(SimulatedPawn->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	}
+	else
+	{
+		CameraBoomComponent->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	}
+}
+
 void APMPlayerController::ChangeState(FName NewState)
 {
 	Super::ChangeState((NewState == NAME_Spectating) ? NAME_Inactive : NewState);
@@ -62,6 +181,16 @@ void APMPlayerController::ChangeState(FName NewState)
 void APMPlayerController::PlayerTick(float DeltaTime)
 {
 	Super::PlayerTick(DeltaTime);
+
+	if (!HasAuthority())
+	{
+		FlushMoveCommand();
+	}
+
+	if (bHasPendingSnapshot)
+	{
+		ShowPendingSnapshot();
+	}
 }
 
 void APMPlayerController::SetupInputComponent()
@@ -70,6 +199,7 @@ void APMPlayerController::SetupInputComponent()
 	Super::SetupInputComponent();
 
 	InputComponent->BindAction("SetDestination", IE_Pressed, this, &APMPlayerController::InputAction_SelectPressed);
+	InputComponent->BindAction("ReportBody", IE_Pressed, this, &APMPlayerController::InputAction_ReportPressed);
 }
 
 void APMPlayerController::SetNewMoveDestination(const FVector& DestLocation)
@@ -79,54 +209,145 @@ void APMPlayerController::SetNewMoveDestination(const FVector& DestLocation)
 	if (HasAuthority())
 	{
 		SimulatedPawn->MoveTo(DestLocation);
-		
 	}
 	else
 	{
-		ServerSetNewMoveDestination(DestLocation);
+		QueueMoveCommand(nullptr, DestLocation);
 	}
 }
 
-void APMPlayerController::ServerSetNewMoveDestination_Implementation(const FVector& DestLocation)
+void APMPlayerController::SetFollowTarget(APMCharacter* Target)
 {
-	if (!SimulatedPawn->IsAlive())
+	check(IsValid(SimulatedPawn) && SimulatedPawn->IsAlive());
+
+	// #todo: we may want to move to a target regardless of its health
+	if (!IsValid(Target) || !Target->IsAlive())
 	{
-		UE_LOG(LogPMPlayerController, Error, TEXT("Attempted to move dead pawn"));
 		return;
 	}
 
-	SetNewMoveDestination(DestLocation);
+	if (HasAuthority())
+	{
+		SimulatedPawn->MoveToActorAndPerformAction(*Target, GetWorld()->GetTimeSeconds());
+	}
+	else
+	{
+		QueueMoveCommand(Target, Target->GetActorLocation());
+	}
 }
 
-void APMPlayerController::SetFollowTarget(APMCharacter* Target)
+void APMPlayerController::QueueMoveCommand(APMCharacter* Target, const FVector& Destination)
 {
-	check(IsValid(SimulatedPawn) && SimulatedPawn->IsAlive());
+	// a newer click simply replaces whatever hasn't gone out or been acknowledged yet
+	PendingCommand.Sequence = ++NextCommandSequence;
+	PendingCommand.bFollow = (Target != nullptr);
+	PendingCommand.Target = Target;
+	PendingCommand.Destination = FVector2D(Destination);
+
+	// what the player sees is as old as the last update from the server, and so is its idea of the server's time
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	PendingCommand.ClientTime = GameState ? GameState->GetServerWorldTimeSeconds() : 0.f;
+	bHasPendingCommand = true;
+	bPendingCommandSent = false;
+
+	FlushMoveCommand();
+}
 
-	// #todo: we may want to move to a target regardless of its health
-	if (!IsValid(Target) || !Target->IsAlive())
+void APMPlayerController::FlushMoveCommand()
+{
+	if (!bHasPendingCommand)
+	{
+		return;
+	}
+
+	if (!IsNewerSequence(PendingCommand.Sequence, AckedCommandSequence))
 	{
+		bHasPendingCommand = false;
 		return;
 	}
 
-	if (HasAuthority() && IsValid(Target))
+	const float Now = GetWorld()->GetRealTimeSeconds();
+	const float Interval = bPendingCommandSent ? CommandResendInterval : (1.f / FMath::Max(MaxCommandsPerSecond, 1.f));
+	if (Now - LastCommandSendTime < Interval)
 	{
-		SimulatedPawn->MoveToActorAndPerformAction(*Target);
+		return;
 	}
-	else
+
+	ServerMoveCommand(PendingCommand);
+	LastCommandSendTime = Now;
+	bPendingCommandSent = true;
+}
+
+bool APMPlayerController::ServerMoveCommand_Validate(const FPMMoveCommand& Command) const
+{
+	const float Now = GetWorld()->GetRealTimeSeconds();
+	CommandTokens = FMath::Min(CommandTokens + (Now - LastCommandTokenTime) * ServerCommandRate, ServerCommandBurst);
+	LastCommandTokenTime = Now;
+	CommandTokens -= 1.f;
+
+	// only dropping commands is left to the implementation, this far over budget it's not a player clicking
+	if (CommandTokens < -ServerCommandKickDeficit)
 	{
-		ServerSetFollowTarget(Target);
+		UE_LOG(LogPMPlayerController, Warning, TEXT("%s is flooding move commands"), *GetNameSafe(PlayerState));
+		return false;
 	}
+
+	return true;
 }
 
-void APMPlayerController::ServerSetFollowTarget_Implementation(APMCharacter* Target)
+void APMPlayerController::ServerMoveCommand_Implementation(const FPMMoveCommand& Command)
 {
-	if (!SimulatedPawn->IsAlive())
+	SCOPE_CYCLE_COUNTER(STAT_PMServerMoveCommand);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, ServerMoveCommand);
+
+	CountServerRPC();
+
+	// resends and packets that arrived out of order
+	if (!IsNewerSequence(Command.Sequence, AckedCommandSequence))
+	{
+		return;
+	}
+
+	// left unacked so the client sends it again, its resends come slower than the bucket refills
+	if (CommandTokens < 0.f)
+	{
+		UE_LOG(LogPMPlayerController, Verbose, TEXT("Dropped move command %d, over the rate limit"), Command.Sequence);
+		return;
+	}
+
+	AckedCommandSequence = Command.Sequence;
+	PM_MARK_PROPERTY_DIRTY(APMPlayerController, AckedCommandSequence);
+
+	if (!IsValid(SimulatedPawn) || !SimulatedPawn->IsAlive())
 	{
 		UE_LOG(LogPMPlayerController, Error, TEXT("Attempted to move dead pawn"));
 		return;
 	}
 
-	SetFollowTarget(Target);
+	if (Command.bFollow)
+	{
+		// judge the click against where the puppets were when the player made it, within reason
+		const float Now = GetWorld()->GetTimeSeconds();
+		const float SeenAtTime = FMath::Clamp(Command.ClientTime, Now - MaxRewindTime, Now);
+
+		APMCharacter* Target = Command.Target;
+		if (!IsValid(Target) || (Target == SimulatedPawn) || !Target->IsAlive())
+		{
+			return;
+		}
+
+		if (FVector2D::DistSquared(FVector2D(Target->GetLocationAt(SeenAtTime)), Command.Destination) > FMath::Square(MaxTargetError))
+		{
+			UE_LOG(LogPMPlayerController, Verbose, TEXT("Ignored move command %d, %s wasn't where it was clicked"), Command.Sequence, *GetNameSafe(Target));
+			return;
+		}
+
+		SimulatedPawn->MoveToActorAndPerformAction(*Target, SeenAtTime);
+	}
+	else
+	{
+		SetNewMoveDestination(FVector(Command.Destination, SimulatedPawn->GetActorLocation().Z));
+	}
 }
 
 void APMPlayerController::InputAction_SelectPressed()
@@ -161,12 +382,107 @@ void APMPlayerController::InputAction_SelectPressed()
 	}
 }
 
+void APMPlayerController::InputAction_ReportPressed()
+{
+	// the server checks the reach, the client's view of the bodies may be behind
+	ServerReportBody();
+}
+
+void APMPlayerController::ServerReportBody_Implementation()
+{
+	CountServerRPC();
+
+	if (!IsValid(SimulatedPawn) || !SimulatedPawn->IsAlive() || SimulatedPawn->IsIncapacitated())
+	{
+		return;
+	}
+
+	// a press that crossed a meeting on the way in
+	APMMatch* Match = SimulatedPawn->GetMatch();
+	if (!Match || !Match->InMatchState(EMatchState::Investigation))
+	{
+		return;
+	}
+
+	if (APMGameModeBase* GameMode = GetWorld()->GetAuthGameMode<APMGameModeBase>())
+	{
+		GameMode->ReportNearestBody(*SimulatedPawn);
+	}
+}
+
 
 void APMPlayerState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(APMPlayerState, MatchStatus);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMPlayerState, Match, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMPlayerState, MatchStatus, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APMPlayerState, MatchSlot, Params);
+}
+
+void APMPlayerState::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	PushModelValidator.Validate(*this);
+}
+
+bool APMPlayerState::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	const APMMatch* ViewerMatch = APMMatch::GetViewerMatch(RealViewer);
+	if (ViewerMatch && Match && (ViewerMatch != Match))
+	{
+		return false;
+	}
+
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+void APMPlayerState::OnDeactivated()
+{
+	if (IsDisconnected())
+	{
+		SetOwner(nullptr);
+		return;
+	}
+
+	Super::OnDeactivated();
+}
+
+void APMPlayerState::OverrideWith(APlayerState* PlayerState)
+{
+	Super::OverrideWith(PlayerState);
+
+	SetPlayerId(PlayerState->GetPlayerId());
+}
+
+void APMPlayerState::OnRep_Match()
+{
+	// the match may have arrived first, in which case it couldn't tell it was ours yet
+	if (Match)
+	{
+		Match->UpdateLocalView();
+	}
+}
+
+void APMPlayerState::SetStatus(EPlayerMatchStatus NewStatus)
+{
+	if (MatchStatus != NewStatus)
+	{
+		MatchStatus = NewStatus;
+		PM_MARK_PROPERTY_DIRTY(APMPlayerState, MatchStatus);
+	}
+}
+
+void APMPlayerState::SetMatch(APMMatch* InMatch, int32 InMatchSlot)
+{
+	Match = InMatch;
+	MatchSlot = InMatchSlot;
+	PM_MARK_PROPERTY_DIRTY(APMPlayerState, Match);
+	PM_MARK_PROPERTY_DIRTY(APMPlayerState, MatchSlot);
 }
 
 void APMPlayerState::SetReady()
@@ -175,7 +491,12 @@ void APMPlayerState::SetReady()
 	{
 		if (HasAuthority())
 		{
-			MatchStatus = EPlayerMatchStatus::Ready;
+			SetStatus(EPlayerMatchStatus::Ready);
+
+			if (APMGameModeBase* GameMode = GetWorld()->GetAuthGameMode<APMGameModeBase>())
+			{
+				GameMode->HandlePlayerReadyChanged(*this);
+			}
 		}
 		else
 		{
@@ -186,5 +507,62 @@ void APMPlayerState::SetReady()
 
 void APMPlayerState::ServerSetReady_Implementation()
 {
+	if (APMPlayerController* PlayerController = Cast<APMPlayerController>(GetOwner()))
+	{
+		PlayerController->CountServerRPC();
+	}
+
 	SetReady();
 }
+
+void APMPlayerState::CastVote(APMPlayerState* Suspect)
+{
+	if (HasAuthority())
+	{
+		if (APMGameModeBase* GameMode = GetWorld()->GetAuthGameMode<APMGameModeBase>())
+		{
+			GameMode->HandlePlayerVote(*this, Suspect);
+		}
+	}
+	else
+	{
+		ServerCastVote(Suspect);
+	}
+}
+
+void APMPlayerState::ServerCastVote_Implementation(APMPlayerState* Suspect)
+{
+	if (APMPlayerController* PlayerController = Cast<APMPlayerController>(GetOwner()))
+	{
+		PlayerController->CountServerRPC();
+	}
+
+	CastVote(Suspect);
+}
+
+void APMPlayerCameraManager::UpdateViewTargetInternal(FTViewTarget& OutVT, float DeltaTime)
+{
+	const APMPlayerController* PlayerController = Cast<APMPlayerController>(PCOwner);
+	UCameraComponent* Camera = PlayerController ? PlayerController->GetCameraComponent() : nullptr;
+
+	// the rig only stands in for the puppet it's attached to, anything else is viewed as usual
+	if (Camera && OutVT.Target && (Camera->GetAttachmentRootActor() == OutVT.Target))
+	{
+		Camera->GetCameraView(DeltaTime, OutVT.POV);
+		return;
+	}
+
+	Super::UpdateViewTargetInternal(OutVT, DeltaTime);
+}
+
+FString UPMLocalPlayer::GetGameLoginOptions() const
+{
+	const FString Options = Super::GetGameLoginOptions();
+	if (ReconnectToken.IsEmpty())
+	{
+		return Options;
+	}
+
+	const FString ReconnectOption = FString::Printf(TEXT("%s=%s"), APMPlayerState::ReconnectTokenOption, *ReconnectToken);
+	return Options.IsEmpty() ? ReconnectOption : (Options + TEXT("?") + ReconnectOption);
+}
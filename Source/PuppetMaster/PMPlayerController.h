@@ -2,14 +2,59 @@
 
 #pragma once
 
+#include "PMMatchTypes.h"
+#include "PMPushModel.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/LocalPlayer.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/PlayerState.h"
 
 #include "PMPlayerController.generated.h"
 
 class APMCharacter;
+class APMMatch;
+class UCameraComponent;
+class USpringArmComponent;
 
-UCLASS()
+/** A click, reduced to what the server needs: where to walk, or who to walk up to. */
+USTRUCT()
+struct FPMMoveCommand
+{
+	GENERATED_BODY()
+
+	/** Commands are unreliable, the server drops anything older than what it already has. */
+	UPROPERTY()
+	uint16 Sequence = 0;
+
+	UPROPERTY()
+	bool bFollow = false;
+
+	/** Only used with bFollow, can be null on the server if the target is gone. */
+	UPROPERTY()
+	APMCharacter* Target = nullptr;
+
+	/** Where to walk, or with bFollow where the player saw the target when it clicked. */
+	UPROPERTY()
+	FVector2D Destination = FVector2D::ZeroVector;
+
+	/** Only used with bFollow, the server time of the world the player was looking at, see APMCharacter::GetLocationAt. */
+	UPROPERTY()
+	float ClientTime = 0.f;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPMMoveCommand> : public TStructOpsTypeTraitsBase2<FPMMoveCommand>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+UCLASS(config = Game)
 class APMPlayerController : public APlayerController
 {
 	GENERATED_BODY()
@@ -19,10 +64,29 @@ public:
 
 	void PostInitializeComponents() override;
 	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 	void SetSimulatedPawn(APawn* InPawn);
 	APawn* GetSimulatedPawn() const;
 
+	/** The local player's view of the puppet it controls, null on the server for remote players. */
+	UCameraComponent* GetCameraComponent() const { return CameraComponent; }
+	USpringArmComponent* GetCameraBoomComponent() const { return CameraBoomComponent; }
+
+	/** Sent to a player who reconnected into a running match, see APMGameModeBase::ReconnectPlayer. */
+	UFUNCTION(Client, Reliable)
+	void ClientMatchSnapshot(const FPMMatchSnapshot& Snapshot);
+	void ClientMatchSnapshot_Implementation(const FPMMatchSnapshot& Snapshot);
+
+	/** Only this player gets their token, it is all it takes to come back as them, see APMPlayerState::GetReconnectToken. */
+	UFUNCTION(Client, Reliable)
+	void ClientReconnectToken(const FString& Token);
+	void ClientReconnectToken_Implementation(const FString& Token);
+
+	/** Server RPCs received from this player so far, for load test stats. */
+	int32 GetNumServerRPCs() const { return NumServerRPCs; }
+	void CountServerRPC() { ++NumServerRPCs; }
+
 protected:
 
 	UPROPERTY(Transient, ReplicatedUsing=OnRep_SimulatedPawn)
@@ -41,37 +105,105 @@ protected:
 	/** Navigate player to the given world location. */
 	void SetNewMoveDestination(const FVector& DestLocation);
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerSetNewMoveDestination(const FVector& DestLocation);
-	void ServerSetNewMoveDestination_Implementation(const FVector& DestLocation);
-	bool ServerSetNewMoveDestination_Validate(const FVector& DestLocation) const { return true; }
-
 	void SetFollowTarget(APMCharacter* Target);
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerSetFollowTarget(APMCharacter* Target);
-	void ServerSetFollowTarget_Implementation(APMCharacter* Target);
-	bool ServerSetFollowTarget_Validate(APMCharacter* Target) const { return true; }
+	/** Clients only keep the latest click and send it at most MaxCommandsPerSecond, see FlushMoveCommand. */
+	void QueueMoveCommand(APMCharacter* Target, const FVector& Destination);
+	void FlushMoveCommand();
+
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerMoveCommand(const FPMMoveCommand& Command);
+	void ServerMoveCommand_Implementation(const FPMMoveCommand& Command);
+	bool ServerMoveCommand_Validate(const FPMMoveCommand& Command) const;
 
 	/** Input handlers for SetDestination action. */
 	void InputAction_SelectPressed();
-};
 
-UENUM(BlueprintType)
-enum class EPlayerMatchStatus : uint8
-{
-	NotReady,
-	Ready,
-	Alive,
-	Dead,
-	Disconnected
+	/** Reports the nearest body within reach of the puppet, if there is one. */
+	void InputAction_ReportPressed();
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReportBody();
+	void ServerReportBody_Implementation();
+	bool ServerReportBody_Validate() const { return true; }
+
+	void ShowPendingSnapshot();
+
+	/** Puppets carry no camera, the local player's one rig follows whichever puppet it is given. */
+	void AttachCameraRig();
+
+	UPROPERTY(EditDefaultsOnly, Category = Camera)
+	float CameraArmLength = 800.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Camera)
+	float CameraPitch = -60.f;
+
+	/** Client send rate for move commands, clicks in between only replace the pending one. */
+	UPROPERTY(config)
+	float MaxCommandsPerSecond = 10.f;
+
+	/** An unacknowledged command is sent again after this long, in case it was lost. */
+	UPROPERTY(config)
+	float CommandResendInterval = 0.25f;
+
+	/** Server side token bucket: commands past the burst are dropped until the rate refills it. */
+	UPROPERTY(config)
+	float ServerCommandRate = 15.f;
+
+	UPROPERTY(config)
+	float ServerCommandBurst = 5.f;
+
+	/** A client this far into its budget isn't clicking anymore and gets disconnected. */
+	UPROPERTY(config)
+	float ServerCommandKickDeficit = 60.f;
+
+	/** Furthest back the server rewinds puppets to judge a click, higher pings are judged as if they had this one. */
+	UPROPERTY(config)
+	float MaxRewindTime = 0.5f;
+
+	/** How far from where the server had the target a click on it may be, past this the click is ignored. */
+	UPROPERTY(config)
+	float MaxTargetError = 150.f;
+
+private:
+
+	int32 NumServerRPCs = 0;
+
+	/** Newest command the server has taken, replicated back to the owner as the ack. */
+	UPROPERTY(Replicated)
+	uint16 AckedCommandSequence = 0;
+
+	FPMMoveCommand PendingCommand;
+	bool bHasPendingCommand = false;
+	bool bPendingCommandSent = false;
+	float LastCommandSendTime = 0.f;
+	uint16 NextCommandSequence = 0;
+
+	/** A reconnect snapshot that came in before the game state did. */
+	FPMMatchSnapshot PendingSnapshot;
+	bool bHasPendingSnapshot = false;
+
+	mutable float CommandTokens = 0.f;
+	mutable float LastCommandTokenTime = 0.f;
+
+	UPROPERTY(Transient)
+	USpringArmComponent* CameraBoomComponent = nullptr;
+
+	UPROPERTY(Transient)
+	UCameraComponent* CameraComponent = nullptr;
+
+	FPMPushModelValidator PushModelValidator;
 };
 
-UENUM(BlueprintType)
-enum class EPlayerVoteStatus : uint8
+/** Views the player's puppet through the controller's camera rig rather than a camera on the puppet. */
+UCLASS()
+class APMPlayerCameraManager : public APlayerCameraManager
 {
-	NoVote,
-	Voted,
+	GENERATED_BODY()
+
+protected:
+
+	void UpdateViewTargetInternal(FTViewTarget& OutVT, float DeltaTime) override;
 };
 
 UCLASS()
@@ -91,21 +223,92 @@ public:
 
 	bool IsReady() const { return MatchStatus == EPlayerMatchStatus::Ready; }
 
-	void SetStatus(EPlayerMatchStatus NewStatus) { MatchStatus = NewStatus; }
+	/** Server side, the player dropped mid-match and is kept for them to come back to. */
+	bool IsDisconnected() const { return MatchStatus == EPlayerMatchStatus::Disconnected; }
+
+	void SetStatus(EPlayerMatchStatus NewStatus);
 
 	UFUNCTION(BlueprintPure)
 	EPlayerMatchStatus GetStatus() const { return MatchStatus; }
 
+	/** Votes to throw Suspect out of the match, or to skip if it is null. Voting again changes the vote. */
+	UFUNCTION(BlueprintCallable)
+	void CastVote(APMPlayerState* Suspect);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerCastVote(APMPlayerState* Suspect);
+	void ServerCastVote_Implementation(APMPlayerState* Suspect);
+	bool ServerCastVote_Validate(APMPlayerState* Suspect) const { return true; }
+
+	APMMatch* GetMatch() const { return Match; }
+
+	/** Where the player is kept in the match's rules, see UPMVoteTracker. */
+	int32 GetMatchSlot() const { return MatchSlot; }
+
+	/** Server only, see APMMatch::AddPlayer. */
+	void SetMatch(APMMatch* InMatch, int32 InMatchSlot);
+
+	/** Disconnected players outlive their controller until they come back or this runs out, owned by APMGameModeBase. */
+	FTimerHandle InactiveTimerHandle;
+
+	/** Login option a client sends its reconnect token back with, see UPMLocalPlayer. */
+	static constexpr const TCHAR* ReconnectTokenOption = TEXT("PMReconnect");
+
+	/**
+	 * Server only. Players without a unique net id are sent a random one to claim this player state back with after a
+	 * drop, see APMGameModeBase::FindInactivePlayer. Until PostLogin it is whatever token they logged in with.
+	 */
+	const FString& GetReconnectToken() const { return ReconnectToken; }
+	void SetReconnectToken(const FString& InReconnectToken) { ReconnectToken = InReconnectToken; }
+
 protected:
 
 	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const;
+	void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** Disconnected players stay around for APMGameModeBase to hand back to them. */
+	void OnDeactivated() override;
+
+	/** A kept player state taking over from a fresh one goes on with its player id too, see APMGameModeBase::ReconnectPlayer. */
+	void OverrideWith(APlayerState* PlayerState) override;
+
+	/** Players only know about the players in their own match. */
+	bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	UFUNCTION()
+	void OnRep_Match();
 
 private:
 
+	UPROPERTY(ReplicatedUsing = OnRep_Match)
+	APMMatch* Match = nullptr;
+
 	UPROPERTY(Replicated)
 	EPlayerMatchStatus MatchStatus;
 
 	UPROPERTY(Replicated)
-	EPlayerVoteStatus VoteStatus;
+	int32 MatchSlot = INDEX_NONE;
+
+	FString ReconnectToken;
+
+	FPMPushModelValidator PushModelValidator;
+
+};
+
+/** Keeps the reconnect token of the last match across a drop and sends it back with the next login. */
+UCLASS()
+class UPMLocalPlayer : public ULocalPlayer
+{
+	GENERATED_BODY()
+
+public:
+
+	FString GetGameLoginOptions() const override;
+
+	void SetReconnectToken(const FString& InReconnectToken) { ReconnectToken = InReconnectToken; }
+
+private:
+
+	FString ReconnectToken;
 
 };
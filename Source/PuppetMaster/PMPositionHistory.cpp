@@ -0,0 +1,47 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMPositionHistory.h"
+
+void FPMPositionHistory::Record(float Time, const FVector2D& Location)
+{
+	const int32 Newest = (Head + Capacity - 1) % Capacity;
+	if ((Num > 0) && (Time - Times[Newest] < SampleInterval))
+	{
+		return;
+	}
+
+	Times[Head] = Time;
+	Locations[Head] = Location;
+	Head = (Head + 1) % Capacity;
+	Num = FMath::Min(Num + 1, Capacity);
+}
+
+void FPMPositionHistory::Reset()
+{
+	Head = 0;
+	Num = 0;
+}
+
+FVector2D FPMPositionHistory::GetLocationAt(float Time, float CurrentTime, const FVector2D& CurrentLocation) const
+{
+	// walk back from now until we pass Time, then interpolate with the sample after it
+	float NextTime = CurrentTime;
+	FVector2D NextLocation = CurrentLocation;
+
+	for (int32 Age = 0; Age < Num; ++Age)
+	{
+		const int32 Index = (Head + Capacity - 1 - Age) % Capacity;
+		if (Times[Index] <= Time)
+		{
+			const float Span = NextTime - Times[Index];
+			const float Alpha = (Span > KINDA_SMALL_NUMBER) ? FMath::Clamp((Time - Times[Index]) / Span, 0.f, 1.f) : 1.f;
+			return FMath::Lerp(Locations[Index], NextLocation, Alpha);
+		}
+
+		NextTime = Times[Index];
+		NextLocation = Locations[Index];
+	}
+
+	return NextLocation;
+}
+
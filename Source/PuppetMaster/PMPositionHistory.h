@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Where a puppet has been over the last second or so, kept on the server to see the match the way a lagging client
+ * saw it when it clicked. Fixed size and allocation free; samples are at least SampleInterval apart, so the buffer
+ * spans about Capacity * SampleInterval seconds. Times and locations are kept apart so lookups only scan times.
+ */
+struct FPMPositionHistory
+{
+	static constexpr int32 Capacity = 32;
+	static constexpr float SampleInterval = 1.f / 30.f;
+
+	/** Samples closer than SampleInterval to the newest one are skipped. */
+	void Record(float Time, const FVector2D& Location);
+
+	/** Forgets everything, for teleports that shouldn't be interpolated across. */
+	void Reset();
+
+	/** Where the puppet was at Time, interpolated between samples and clamped to the oldest one. */
+	FVector2D GetLocationAt(float Time, float CurrentTime, const FVector2D& CurrentLocation) const;
+
+private:
+
+	float Times[Capacity];
+	FVector2D Locations[Capacity];
+
+	/** Where the next sample goes. */
+	int32 Head = 0;
+	int32 Num = 0;
+};
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMProximitySubsystem.h"
+
+#include "PMCharacter.h"
+#include "PuppetMaster.h"
+
+DECLARE_CYCLE_STAT(TEXT("Proximity Query"), STAT_PMProximityQuery, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proximity Cell Changes"), STAT_PMProximityCellChanges, STATGROUP_PuppetMaster);
+
+void UPMProximitySubsystem::RegisterCharacter(APMCharacter& Character)
+{
+	check(!Entries.Contains(&Character));
+	check(Character.GetRootComponent());
+
+	FEntry& Entry = Entries.Add(&Character);
+	Entry.Cell = GetCell(Character.GetActorLocation());
+	Entry.MovedHandle = Character.GetRootComponent()->TransformUpdated.AddUObject(this, &UPMProximitySubsystem::OnCharacterMoved);
+
+	AddToCell(Character, Entry.Cell);
+}
+
+void UPMProximitySubsystem::UnregisterCharacter(APMCharacter& Character)
+{
+	FEntry Entry;
+	if (Entries.RemoveAndCopyValue(&Character, Entry))
+	{
+		if (Character.GetRootComponent())
+		{
+			Character.GetRootComponent()->TransformUpdated.Remove(Entry.MovedHandle);
+		}
+
+		RemoveFromCell(Character, Entry.Cell);
+	}
+}
+
+void UPMProximitySubsystem::ForEachCharacterInRange(const APMCharacter& Origin, float Radius, const TFunctionRef<void(APMCharacter& Character)>& Visit) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMProximityQuery);
+
+	const FVector Location = Origin.GetActorLocation();
+	const FIntPoint MinCell = GetCell(Location - FVector(Radius, Radius, 0.f));
+	const FIntPoint MaxCell = GetCell(Location + FVector(Radius, Radius, 0.f));
+	const float RadiusSquared = FMath::Square(Radius);
+
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			const auto* Cell = Cells.Find(FIntPoint(X, Y));
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (APMCharacter* Character : *Cell)
+			{
+				// matches are hosted far apart, but not necessarily further than a cell
+				if ((Character != &Origin) && (Character->GetMatch() == Origin.GetMatch())
+					&& (FVector::DistSquared2D(Character->GetActorLocation(), Location) <= RadiusSquared))
+				{
+					Visit(*Character);
+				}
+			}
+		}
+	}
+}
+
+APMCharacter* UPMProximitySubsystem::FindNearestBody(const APMCharacter& Reporter) const
+{
+	APMCharacter* NearestBody = nullptr;
+	float NearestDistanceSquared = MAX_flt;
+
+	const FVector Location = Reporter.GetActorLocation();
+	ForEachCharacterInRange(Reporter, InteractionRange, [&](APMCharacter& Character)
+	{
+		const float DistanceSquared = FVector::DistSquared2D(Character.GetActorLocation(), Location);
+		if (!Character.IsAlive() && (DistanceSquared < NearestDistanceSquared))
+		{
+			NearestBody = &Character;
+			NearestDistanceSquared = DistanceSquared;
+		}
+	});
+
+	return NearestBody;
+}
+
+bool UPMProximitySubsystem::IsInInteractionRange(const APMCharacter& A, const APMCharacter& B) const
+{
+	return (A.GetMatch() == B.GetMatch()) && (FVector::DistSquared2D(A.GetActorLocation(), B.GetActorLocation()) <= FMath::Square(InteractionRange));
+}
+
+bool UPMProximitySubsystem::IsInInteractionRangeAt(const APMCharacter& A, const APMCharacter& B, float Time) const
+{
+	return (A.GetMatch() == B.GetMatch()) && (FVector::DistSquared2D(A.GetLocationAt(Time), B.GetLocationAt(Time)) <= FMath::Square(InteractionRange));
+}
+
+void UPMProximitySubsystem::OnCharacterMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	APMCharacter* Character = Cast<APMCharacter>(UpdatedComponent->GetOwner());
+	FEntry* Entry = Character ? Entries.Find(Character) : nullptr;
+	if (!Entry)
+	{
+		return;
+	}
+
+	// most moves stay within the cell
+	const FIntPoint NewCell = GetCell(Character->GetActorLocation());
+	if (NewCell != Entry->Cell)
+	{
+		INC_DWORD_STAT(STAT_PMProximityCellChanges);
+
+		RemoveFromCell(*Character, Entry->Cell);
+		AddToCell(*Character, NewCell);
+		Entry->Cell = NewCell;
+	}
+}
+
+void UPMProximitySubsystem::AddToCell(APMCharacter& Character, const FIntPoint& Cell)
+{
+	Cells.FindOrAdd(Cell).Add(&Character);
+}
+
+void UPMProximitySubsystem::RemoveFromCell(APMCharacter& Character, const FIntPoint& Cell)
+{
+	if (auto* Characters = Cells.Find(Cell))
+	{
+		Characters->RemoveSingleSwap(&Character);
+		if (Characters->Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+}
+
+FIntPoint UPMProximitySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Components/SceneComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PMProximitySubsystem.generated.h"
+
+class APMCharacter;
+
+/**
+ * Server side index of where the puppets are, for "who is within reach of whom" questions.
+ * Puppets are bucketed into a uniform grid that is kept up to date as they move, so range queries only look at the
+ * puppets in the handful of cells the range overlaps.
+ */
+UCLASS(config = Game)
+class UPMProximitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	void RegisterCharacter(APMCharacter& Character);
+	void UnregisterCharacter(APMCharacter& Character);
+
+	/** Calls Visit for every puppet of the same match as Origin within Radius of it, Origin excluded. */
+	void ForEachCharacterInRange(const APMCharacter& Origin, float Radius, const TFunctionRef<void(APMCharacter& Character)>& Visit) const;
+
+	/** The closest body within reach of Reporter, if any. */
+	APMCharacter* FindNearestBody(const APMCharacter& Reporter) const;
+
+	/** How close puppets have to be to kill, revive or report each other. */
+	float GetInteractionRange() const { return InteractionRange; }
+	bool IsInInteractionRange(const APMCharacter& A, const APMCharacter& B) const;
+
+	/** The same, with both puppets where they were at a recent server Time, see APMCharacter::GetLocationAt. */
+	bool IsInInteractionRangeAt(const APMCharacter& A, const APMCharacter& B, float Time) const;
+
+private:
+
+	void OnCharacterMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	void AddToCell(APMCharacter& Character, const FIntPoint& Cell);
+	void RemoveFromCell(APMCharacter& Character, const FIntPoint& Cell);
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	struct FEntry
+	{
+		FIntPoint Cell;
+		FDelegateHandle MovedHandle;
+	};
+
+	TMap<FIntPoint, TArray<APMCharacter*, TInlineAllocator<4>>> Cells;
+	TMap<const APMCharacter*, FEntry> Entries;
+
+	UPROPERTY(config)
+	float CellSize = 400.f;
+
+	UPROPERTY(config)
+	float InteractionRange = 150.f;
+
+};
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMPushModel.h"
+
+#include "UObject/Package.h"
+#include "UObject/UnrealType.h"
+
+#if PM_VALIDATE_PUSH_MODEL
+
+namespace
+{
+	/** Engine properties replicate the way the engine set them up, only ours are push based. */
+	bool IsPuppetMasterProperty(const FProperty& Property)
+	{
+		static const FName ModulePackageName(TEXT("/Script/PuppetMaster"));
+
+		const UClass* OwnerClass = Property.GetOwnerClass();
+		return Property.HasAnyPropertyFlags(CPF_Net) && OwnerClass && (OwnerClass->GetOutermost()->GetFName() == ModulePackageName);
+	}
+}
+
+FPMPushModelValidator::~FPMPushModelValidator()
+{
+	for (FSnapshot& Snapshot : Snapshots)
+	{
+		Snapshot.Property->DestroyValue(Snapshot.Value);
+		FMemory::Free(Snapshot.Value);
+	}
+}
+
+void FPMPushModelValidator::MarkDirty(const UObject& Owner, FName PropertyName)
+{
+	for (FSnapshot& Snapshot : Snapshots)
+	{
+		if (Snapshot.Property->GetFName() == PropertyName)
+		{
+			UpdateSnapshot(Owner, Snapshot);
+			return;
+		}
+	}
+}
+
+void FPMPushModelValidator::Validate(const UObject& Owner)
+{
+	if (!bHasSnapshots)
+	{
+		TakeSnapshots(Owner);
+		return;
+	}
+
+	for (FSnapshot& Snapshot : Snapshots)
+	{
+		if (!Snapshot.Property->Identical(Snapshot.Property->ContainerPtrToValuePtr<void>(&Owner), Snapshot.Value))
+		{
+			ensureMsgf(false, TEXT("%s.%s was written without being marked dirty and will not replicate"), *Owner.GetName(), *Snapshot.Property->GetName());
+
+			// only complain once per write
+			UpdateSnapshot(Owner, Snapshot);
+		}
+	}
+}
+
+void FPMPushModelValidator::TakeSnapshots(const UObject& Owner)
+{
+	bHasSnapshots = true;
+
+	for (TFieldIterator<FProperty> It(Owner.GetClass()); It; ++It)
+	{
+		if (IsPuppetMasterProperty(**It))
+		{
+			FSnapshot& Snapshot = Snapshots.AddDefaulted_GetRef();
+			Snapshot.Property = *It;
+			Snapshot.Value = static_cast<uint8*>(FMemory::Malloc(Snapshot.Property->GetSize(), Snapshot.Property->GetMinAlignment()));
+			Snapshot.Property->InitializeValue(Snapshot.Value);
+			UpdateSnapshot(Owner, Snapshot);
+		}
+	}
+}
+
+void FPMPushModelValidator::UpdateSnapshot(const UObject& Owner, FSnapshot& Snapshot)
+{
+	Snapshot.Property->CopyCompleteValue(Snapshot.Value, Snapshot.Property->ContainerPtrToValuePtr<void>(&Owner));
+}
+
+#endif
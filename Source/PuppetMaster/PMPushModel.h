@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+/** Debug builds check that push model properties aren't written without being marked dirty. */
+#ifndef PM_VALIDATE_PUSH_MODEL
+#define PM_VALIDATE_PUSH_MODEL !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+#endif
+
+/**
+ * Push model properties are only compared when marked dirty, so a write that forgets to mark them never reaches
+ * clients. The validator keeps a copy of each replicated PuppetMaster property of its owner as of the last time it
+ * was marked, and complains when the owner is about to replicate with a value that differs from it.
+ */
+class FPMPushModelValidator
+{
+public:
+
+	FPMPushModelValidator() = default;
+	FPMPushModelValidator(const FPMPushModelValidator&) = delete;
+	FPMPushModelValidator& operator=(const FPMPushModelValidator&) = delete;
+
+#if PM_VALIDATE_PUSH_MODEL
+	~FPMPushModelValidator();
+
+	void MarkDirty(const UObject& Owner, FName PropertyName);
+
+	/** Call from PreReplication, on the server. */
+	void Validate(const UObject& Owner);
+
+private:
+
+	struct FSnapshot
+	{
+		const FProperty* Property = nullptr;
+		uint8* Value = nullptr;
+	};
+
+	void TakeSnapshots(const UObject& Owner);
+	void UpdateSnapshot(const UObject& Owner, FSnapshot& Snapshot);
+
+	TArray<FSnapshot> Snapshots;
+	bool bHasSnapshots = false;
+#else
+	void MarkDirty(const UObject& Owner, FName PropertyName) {}
+	void Validate(const UObject& Owner) {}
+#endif
+
+};
+
+/** Marks a push model property of this dirty, write the new value first. The class needs a PushModelValidator. */
+#define PM_MARK_PROPERTY_DIRTY(ClassName, PropertyName) \
+	do \
+	{ \
+		MARK_PROPERTY_DIRTY_FROM_NAME(ClassName, PropertyName, this); \
+		PushModelValidator.MarkDirty(*this, GET_MEMBER_NAME_CHECKED(ClassName, PropertyName)); \
+	} \
+	while (0)
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMReplicatedPath.h"
+
+#include "PMNetSerialization.h"
+
+#include "AI/Navigation/NavigationTypes.h"
+
+bool FPMPathPoint::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedSequence = static_cast<uint32>(Sequence);
+	PMNetSerialization::SerializePlanarLocation(Ar, Location);
+	Ar.SerializeIntPacked(PackedSequence);
+
+	if (Ar.IsLoading())
+	{
+		Sequence = static_cast<int32>(PackedSequence);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FPMReplicatedPath::SetRemainingPath(const TArray<FNavPathPoint>& NavPoints, int32 CurrentPathIndex)
+{
+	const int32 FirstRemaining = FMath::Max(CurrentPathIndex + 1, 0);
+	const int32 NumRemaining = FMath::Max(NavPoints.Num() - FirstRemaining, 0);
+
+	// advancing along the same path only ever drops points off the front
+	bool bIsSuffix = (NumRemaining <= Points.Num());
+	for (int32 i = 0; bIsSuffix && (i < NumRemaining); ++i)
+	{
+		bIsSuffix = (Points[Points.Num() - NumRemaining + i].Location == PMNetSerialization::QuantizePlanar(FVector2D(NavPoints[FirstRemaining + i].Location)));
+	}
+
+	if (bIsSuffix)
+	{
+		const int32 NumPassed = Points.Num() - NumRemaining;
+		if (NumPassed > 0)
+		{
+			Points.RemoveAt(0, NumPassed);
+			MarkArrayDirty();
+			return true;
+		}
+		return false;
+	}
+
+	Points.Reset(NumRemaining);
+	for (int32 i = FirstRemaining; i < NavPoints.Num(); ++i)
+	{
+		FPMPathPoint& Point = Points.AddDefaulted_GetRef();
+		Point.Location = PMNetSerialization::QuantizePlanar(FVector2D(NavPoints[i].Location));
+		Point.Sequence = NextSequence++;
+		MarkItemDirty(Point);
+	}
+	MarkArrayDirty();
+	return true;
+}
+
+bool FPMReplicatedPath::Clear()
+{
+	if (Points.Num() > 0)
+	{
+		Points.Reset();
+		MarkArrayDirty();
+		return true;
+	}
+	return false;
+}
+
+void FPMReplicatedPath::GetPoints(float Height, TArray<FVector>& OutPoints) const
+{
+	TArray<const FPMPathPoint*, TInlineAllocator<32>> Ordered;
+	for (const FPMPathPoint& Point : Points)
+	{
+		Ordered.Add(&Point);
+	}
+	Ordered.Sort([](const FPMPathPoint& A, const FPMPathPoint& B) { return A.Sequence < B.Sequence; });
+
+	OutPoints.Reset(Ordered.Num());
+	for (const FPMPathPoint* Point : Ordered)
+	{
+		OutPoints.Emplace(Point->Location.X, Point->Location.Y, Height);
+	}
+}
@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+
+#include "PMReplicatedPath.generated.h"
+
+struct FNavPathPoint;
+
+/** One remaining point of a puppet's path, flattened onto the movement plane. */
+USTRUCT()
+struct FPMPathPoint : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector2D Location = FVector2D::ZeroVector;
+
+	/** Fast arrays don't keep their order on clients, so points carry their position along the path. */
+	UPROPERTY()
+	int32 Sequence = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPMPathPoint> : public TStructOpsTypeTraitsBase2<FPMPathPoint>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * The part of a puppet's path it has yet to walk. As the puppet advances only the removal of passed points is
+ * replicated; the whole path is only resent when it actually changes.
+ */
+USTRUCT()
+struct FPMReplicatedPath : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	/** Makes the replicated path match the nav path points after CurrentPathIndex. Returns true if it changed. */
+	bool SetRemainingPath(const TArray<FNavPathPoint>& NavPoints, int32 CurrentPathIndex);
+
+	/** Returns true if there was anything to clear. */
+	bool Clear();
+
+	/** Remaining points in walking order, at the given height. */
+	void GetPoints(float Height, TArray<FVector>& OutPoints) const;
+
+	int32 Num() const { return Points.Num(); }
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FPMPathPoint, FPMReplicatedPath>(Points, DeltaParms, *this);
+	}
+
+private:
+
+	UPROPERTY()
+	TArray<FPMPathPoint> Points;
+
+	int32 NextSequence = 0;
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FPMReplicatedPath> : public TStructOpsTypeTraitsBase2<FPMReplicatedPath>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
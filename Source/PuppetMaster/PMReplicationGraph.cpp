@@ -0,0 +1,208 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMReplicationGraph.h"
+
+#include "PMCharacter.h"
+#include "PMMatch.h"
+#include "PMPlayerController.h"
+#include "PMVisibilitySubsystem.h"
+#include "PuppetMaster.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Line Of Sight Culling"), STAT_PMLineOfSightCulling, STATGROUP_PuppetMaster);
+
+namespace
+{
+	// per connection cull distance given to puppets the connection's puppet can't see
+	constexpr float HiddenCullDistanceSquared = 1.f;
+}
+
+void UPMReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	const APMCharacter* CharacterCDO = GetDefault<APMCharacter>();
+
+	FClassReplicationInfo CharacterInfo;
+	CharacterInfo.DistancePriorityScale = 1.f;
+	CharacterInfo.StarvationPriorityScale = 1.f;
+	CharacterInfo.ActorChannelFrameTimeout = 4;
+	CharacterInfo.CullDistanceSquared = FMath::Square(CharacterCullDistance);
+	CharacterInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(CharacterCDO->NetUpdateFrequency);
+	GlobalActorReplicationInfoMap.SetClassInfo(APMCharacter::StaticClass(), CharacterInfo);
+
+	// puppets get their own row in the replication graph's csv stats
+	CSVTracker.SetExplicitClassTracking(APMCharacter::StaticClass(), TEXT("Character"));
+
+	// statuses only change a handful of times per match
+	FClassReplicationInfo PlayerStateInfo;
+	PlayerStateInfo.DistancePriorityScale = 0.f;
+	PlayerStateInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(GetDefault<APMPlayerState>()->NetUpdateFrequency);
+	GlobalActorReplicationInfoMap.SetClassInfo(APMPlayerState::StaticClass(), PlayerStateInfo);
+}
+
+void UPMReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UPMReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	AddConnectionGraphNode(CreateNewNode<UPMReplicationGraphNode_AlwaysRelevant_ForConnection>(), RepGraphConnection);
+	AddConnectionGraphNode(CreateNewNode<UPMReplicationGraphNode_PlayerStates_ForConnection>(), RepGraphConnection);
+	AddConnectionGraphNode(CreateNewNode<UPMReplicationGraphNode_Characters_ForConnection>(), RepGraphConnection);
+}
+
+void UPMReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	if (Actor->IsA<APMCharacter>() || Actor->IsA<APMPlayerState>() || Actor->IsA<APMMatch>())
+	{
+		// scoped to the connection's match, see the per connection nodes
+	}
+	else if (Actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+	}
+	else if (Actor->bOnlyRelevantToOwner)
+	{
+		// player controllers, picked up by UPMReplicationGraphNode_AlwaysRelevant_ForConnection
+	}
+	else if (Actor->IsRootComponentMovable())
+	{
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+	}
+	else
+	{
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+	}
+}
+
+void UPMReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	if (Actor->IsA<APMCharacter>() || Actor->IsA<APMPlayerState>() || Actor->IsA<APMMatch>())
+	{
+	}
+	else if (Actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+	}
+	else if (Actor->bOnlyRelevantToOwner)
+	{
+	}
+	else if (Actor->IsRootComponentMovable())
+	{
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+	}
+	else
+	{
+		GridNode->RemoveActor_Static(ActorInfo);
+	}
+}
+
+int32 UPMReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	UpdateLineOfSightCulling();
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+void UPMReplicationGraph::UpdateLineOfSightCulling()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMLineOfSightCulling);
+
+	UPMVisibilitySubsystem* Visibility = GetWorld()->GetSubsystem<UPMVisibilitySubsystem>();
+	if (!Visibility)
+	{
+		return;
+	}
+
+	const float VisibleCullDistanceSquared = FMath::Square(CharacterCullDistance);
+
+	// the graph never calls IsNetRelevantFor, so hidden puppets are culled through their distance check instead
+	for (UNetReplicationGraphConnection* Connection : Connections)
+	{
+		const AActor* Viewer = Connection->NetConnection->PlayerController;
+		const APMMatch* Match = APMMatch::GetViewerMatch(Viewer);
+		if (!Match)
+		{
+			continue;
+		}
+
+		const APMCharacter* ViewerPawn = Visibility->GetLineOfSightViewer(Viewer, Match);
+		for (APMCharacter* Character : Match->GetCharacters())
+		{
+			const bool bHidden = ViewerPawn && !Visibility->CanSee(*ViewerPawn, *Character);
+
+			FConnectionReplicationActorInfo& ConnectionInfo = Connection->ActorInfoMap.FindOrAdd(Character);
+			ConnectionInfo.CullDistanceSquared = bHidden ? HiddenCullDistanceSquared : VisibleCullDistanceSquared;
+		}
+	}
+}
+
+void UPMReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	APMPlayerController* PlayerController = Cast<APMPlayerController>(Params.ConnectionManager.NetConnection->PlayerController);
+	if (PlayerController)
+	{
+		ReplicationActorList.ConditionalAdd(PlayerController);
+		ReplicationActorList.ConditionalAdd(PlayerController->PlayerState);
+		ReplicationActorList.ConditionalAdd(PlayerController->GetSimulatedPawn());
+
+		if (const APMPlayerState* PlayerState = PlayerController->GetPlayerState<APMPlayerState>())
+		{
+			ReplicationActorList.ConditionalAdd(PlayerState->GetMatch());
+		}
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
+
+void UPMReplicationGraphNode_PlayerStates_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	const APMMatch* Match = APMMatch::GetViewerMatch(Params.ConnectionManager.NetConnection->PlayerController);
+	if (Match)
+	{
+		for (APMPlayerState* Player : Match->GetPlayers())
+		{
+			ReplicationActorList.ConditionalAdd(Player);
+		}
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
+
+void UPMReplicationGraphNode_Characters_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	const APMMatch* Match = APMMatch::GetViewerMatch(Params.ConnectionManager.NetConnection->PlayerController);
+	if (Match)
+	{
+		for (APMCharacter* Character : Match->GetCharacters())
+		{
+			ReplicationActorList.ConditionalAdd(Character);
+		}
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
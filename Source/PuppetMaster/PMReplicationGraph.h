@@ -0,0 +1,116 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "EngineDefines.h"
+#include "ReplicationGraph.h"
+
+#include "PMReplicationGraph.generated.h"
+
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+/**
+ * Replication graph for PuppetMaster.
+ * The game state is always relevant and every connection gets its own controller, puppet, match and the player states
+ * and puppets of that match through per connection nodes. Everything else is spatialized in a grid.
+ */
+UCLASS(transient, config = Engine)
+class UPMReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+
+	void InitGlobalActorClassSettings() override;
+	void InitGlobalGraphNodes() override;
+	void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	int32 ServerReplicateActors(float DeltaSeconds) override;
+
+protected:
+
+	UPROPERTY(config)
+	float GridCellSize = 5000.f;
+
+	/** Matches are laid out around the world origin, see APMGameModeBase::GetMatchOrigin. */
+	UPROPERTY(config)
+	FVector2D GridSpatialBias = FVector2D(-HALF_WORLD_MAX, -HALF_WORLD_MAX);
+
+	UPROPERTY(config)
+	float CharacterCullDistance = 15000.f;
+
+private:
+
+	/** Feeds UPMVisibilitySubsystem into the per connection cull distance of the puppets in the connection's match. */
+	void UpdateLineOfSightCulling();
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode = nullptr;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode = nullptr;
+
+};
+
+/** The connection's own controller, its player state, its match and its simulated puppet, which it doesn't own. */
+UCLASS()
+class UPMReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+	bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	void NotifyResetAllNetworkActors() override {}
+
+	void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+
+	FActorRepListRefView ReplicationActorList;
+
+};
+
+/** Player states the connection needs for its status list, which are the ones in its match. */
+UCLASS()
+class UPMReplicationGraphNode_PlayerStates_ForConnection : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+	bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	void NotifyResetAllNetworkActors() override {}
+
+	void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+
+	FActorRepListRefView ReplicationActorList;
+
+};
+
+/** Puppets of the connection's match, puppets of other matches are never even looked at for it. */
+UCLASS()
+class UPMReplicationGraphNode_Characters_ForConnection : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+	bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	void NotifyResetAllNetworkActors() override {}
+
+	void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+
+	FActorRepListRefView ReplicationActorList;
+
+};
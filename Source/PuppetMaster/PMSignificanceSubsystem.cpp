@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMSignificanceSubsystem.h"
+
+#include "PMCharacter.h"
+#include "PMPlayerController.h"
+#include "PuppetMaster.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "SignificanceManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_PMSignificanceUpdate, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Full Rate Puppets"), STAT_PMFullRatePuppets, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Reduced Rate Puppets"), STAT_PMReducedRatePuppets, STATGROUP_PuppetMaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Insignificant Puppets"), STAT_PMInsignificantPuppets, STATGROUP_PuppetMaster);
+
+static const FName PuppetSignificanceTag(TEXT("Puppet"));
+
+void UPMSignificanceSubsystem::RegisterCharacter(APMCharacter& Character)
+{
+	check(!Entries.ContainsByPredicate([&Character](const FEntry& Entry) { return Entry.Character == &Character; }));
+
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (!SignificanceManager)
+	{
+		return;
+	}
+
+	Entries.Add({ &Character, ETier::Unmanaged });
+
+	SignificanceManager->RegisterObject(&Character, PuppetSignificanceTag,
+		[this](USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint)
+		{
+			return CalculateSignificance(*CastChecked<APMCharacter>(ObjectInfo->GetObject()), Viewpoint);
+		});
+}
+
+void UPMSignificanceSubsystem::UnregisterCharacter(APMCharacter& Character)
+{
+	const int32 NumRemoved = Entries.RemoveAllSwap([&Character](const FEntry& Entry) { return Entry.Character == &Character; });
+	if (NumRemoved == 0)
+	{
+		return;
+	}
+
+	if (USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld()))
+	{
+		SignificanceManager->UnregisterObject(&Character);
+	}
+
+	// a pooled puppet comes back at full rate
+	ApplyTier(Character, ETier::Full);
+}
+
+void UPMSignificanceSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMSignificanceUpdate);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, SignificanceUpdate);
+
+	const APMPlayerController* LocalPlayer = Cast<APMPlayerController>(GEngine->GetFirstLocalPlayerController(GetWorld()));
+	const APawn* ViewPawn = LocalPlayer ? LocalPlayer->GetSimulatedPawn() : nullptr;
+	if (!ViewPawn)
+	{
+		return;
+	}
+
+	const FTransform Viewpoint = ViewPawn->GetActorTransform();
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	SignificanceManager->Update(MakeArrayView(&Viewpoint, 1));
+
+	RankedScratch.Reset();
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		APMCharacter& Character = *Entries[Index].Character;
+
+		// UPMCorpseSubsystem owns a body's mesh until it's revived, which then finds it at full rate
+		if (Character.IsIncapacitated())
+		{
+			Entries[Index].Tier = ETier::Unmanaged;
+			continue;
+		}
+
+		RankedScratch.Add({ SignificanceManager->GetSignificance(&Character), Index });
+	}
+
+	RankedScratch.Sort([](const FRanked& A, const FRanked& B) { return A.Significance > B.Significance; });
+
+	for (int32 Rank = 0; Rank < RankedScratch.Num(); ++Rank)
+	{
+		FEntry& Entry = Entries[RankedScratch[Rank].EntryIndex];
+
+		ETier Tier = ETier::Off;
+		if (Entry.Character == ViewPawn)
+		{
+			Tier = ETier::Full;
+		}
+		else if (RankedScratch[Rank].Significance > 0.f)
+		{
+			Tier = (Rank < FullRateBudget) ? ETier::Full : (Rank < FullRateBudget + ReducedRateBudget) ? ETier::Reduced : ETier::Off;
+		}
+
+		switch (Tier)
+		{
+		case ETier::Full: INC_DWORD_STAT(STAT_PMFullRatePuppets); break;
+		case ETier::Reduced: INC_DWORD_STAT(STAT_PMReducedRatePuppets); break;
+		default: INC_DWORD_STAT(STAT_PMInsignificantPuppets); break;
+		}
+
+		if (Tier != Entry.Tier)
+		{
+			ApplyTier(*Entry.Character, Tier);
+			Entry.Tier = Tier;
+		}
+	}
+}
+
+TStatId UPMSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPMSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+float UPMSignificanceSubsystem::CalculateSignificance(const APMCharacter& Character, const FTransform& Viewpoint) const
+{
+	if (!Character.IsAlive() || Character.IsIncapacitated() || Character.IsHidden())
+	{
+		return 0.f;
+	}
+
+	const float Distance = FVector::Dist2D(Character.GetActorLocation(), Viewpoint.GetLocation());
+	float Significance = FMath::Clamp(1.f - Distance / SignificanceDistance, 0.f, 1.f);
+
+	// anything on screen beats anything off it, nearer first either way
+	if (Character.WasRecentlyRendered(0.2f))
+	{
+		Significance += 1.f;
+	}
+
+	return Significance;
+}
+
+void UPMSignificanceSubsystem::ApplyTier(APMCharacter& Character, ETier Tier) const
+{
+	USkeletalMeshComponent* Mesh = Character.GetMesh();
+	UCharacterMovementComponent* Movement = Character.GetCharacterMovement();
+
+	// a listen server still simulates its puppets properly, only smoothing on simulated proxies may slow down
+	const bool bSimulatedProxy = (Character.GetLocalRole() == ROLE_SimulatedProxy);
+
+	// ticking at an interval hands the skipped time to the next tick, so animation and smoothing just step further
+	switch (Tier)
+	{
+	case ETier::Full:
+		Mesh->SetComponentTickEnabled(true);
+		Mesh->SetComponentTickInterval(0.f);
+		Movement->SetComponentTickInterval(0.f);
+		break;
+
+	case ETier::Reduced:
+		Mesh->SetComponentTickEnabled(true);
+		Mesh->SetComponentTickInterval(ReducedTickInterval);
+		Movement->SetComponentTickInterval(0.f);
+		break;
+
+	case ETier::Off:
+		// the pose stays where it was, nobody is looking
+		Mesh->SetComponentTickEnabled(false);
+		Movement->SetComponentTickInterval(bSimulatedProxy ? ReducedTickInterval : 0.f);
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,77 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "PMSignificanceSubsystem.generated.h"
+
+class APMCharacter;
+
+/**
+ * Client side animation budget for crowds of puppets. Puppets are ranked with the significance manager by how close
+ * they are to the local player's puppet and whether they are on screen. The top FullRateBudget animate every frame,
+ * the next ReducedRateBudget every ReducedTickInterval, and the rest don't update their skeleton at all.
+ * Bodies are left to UPMCorpseSubsystem, which already keeps them frozen.
+ */
+UCLASS(config = Game)
+class UPMSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void RegisterCharacter(APMCharacter& Character);
+	void UnregisterCharacter(APMCharacter& Character);
+
+	// Begin FTickableGameObject interface
+	void Tick(float DeltaTime) override;
+	bool IsTickable() const override { return Entries.Num() > 0; }
+	TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+private:
+
+	enum class ETier : uint8
+	{
+		/** Not set by us yet, or handed to UPMCorpseSubsystem. */
+		Unmanaged,
+		Full,
+		Reduced,
+		Off
+	};
+
+	float CalculateSignificance(const APMCharacter& Character, const FTransform& Viewpoint) const;
+	void ApplyTier(APMCharacter& Character, ETier Tier) const;
+
+	struct FEntry
+	{
+		APMCharacter* Character;
+		ETier Tier;
+	};
+
+	TArray<FEntry> Entries;
+
+	struct FRanked
+	{
+		float Significance;
+		int32 EntryIndex;
+	};
+
+	TArray<FRanked> RankedScratch;
+
+	UPROPERTY(config)
+	int32 FullRateBudget = 8;
+
+	UPROPERTY(config)
+	int32 ReducedRateBudget = 24;
+
+	UPROPERTY(config)
+	float ReducedTickInterval = 0.1f;
+
+	/** Puppets further than this from the local puppet only count when on screen. */
+	UPROPERTY(config)
+	float SignificanceDistance = 3000.f;
+
+};
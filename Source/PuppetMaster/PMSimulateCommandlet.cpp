@@ -0,0 +1,312 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMSimulateCommandlet.h"
+
+#include "PMGameMode.h"
+#include "PMMatchRules.h"
+#include "PuppetMaster.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Parse.h"
+
+namespace
+{
+	/** How the scripted players behave, all times in seconds. */
+	struct FPlayerTuning
+	{
+		/** Mean time between a killer's attempts while someone is standing. */
+		float KillInterval = 30.f;
+
+		/** Mean time until someone stumbles over a body. */
+		float ReportInterval = 20.f;
+
+		/** Mean time until someone helps a passed out puppet up. */
+		float ReviveInterval = 15.f;
+
+		/** Mean time between meetings called without a body. */
+		float MeetingInterval = 240.f;
+
+		/** Mean time a player takes to cast their vote. */
+		float VoteTime = 10.f;
+
+		/** Discussion needed to point at the right suspect, longer discussions get closer to certain. */
+		float ClueTime = 45.f;
+
+		/** Matches still running by then are counted as stalled. */
+		float MaxMatchLength = 1800.f;
+	};
+
+	struct FMatchResult
+	{
+		ERulesOutcome Outcome = ERulesOutcome::None;
+		float Length = 0.f;
+		int32 NumMeetings = 0;
+		int32 NumKnockdowns = 0;
+		int32 NumKills = 0;
+		int32 NumRevives = 0;
+		int32 NumEjections = 0;
+		int32 NumKillersEjected = 0;
+	};
+
+	/** Chance of something with the given mean interval happening within a second. */
+	float PerSecond(float Interval)
+	{
+		return Interval > 0.f ? 1.f / Interval : 0.f;
+	}
+
+	template <typename PredicateType>
+	int32 PickSlot(const FPMMatchRules& Rules, FRandomStream& Random, PredicateType Predicate)
+	{
+		TArray<int32, TInlineAllocator<16>> Candidates;
+		for (int32 Slot = 0; Slot < Rules.GetNumSlots(); ++Slot)
+		{
+			if (Predicate(Slot))
+			{
+				Candidates.Add(Slot);
+			}
+		}
+
+		return Candidates.Num() > 0 ? Candidates[Random.RandRange(0, Candidates.Num() - 1)] : INDEX_NONE;
+	}
+
+	/** One second of everyone going about their business. */
+	void SimulateInvestigation(FPMMatchRules& Rules, const FPlayerTuning& Tuning, FRandomStream& Random, int32& NumBodies, FMatchResult& Result)
+	{
+		for (int32 Slot = 0; Slot < Rules.GetNumSlots(); ++Slot)
+		{
+			if (!Rules.IsAlive(Slot) || Rules.IsIncapacitated(Slot))
+			{
+				continue;
+			}
+
+			if (Rules.IsKiller(Slot))
+			{
+				if (Random.FRand() < PerSecond(Tuning.KillInterval))
+				{
+					const int32 Victim = PickSlot(Rules, Random, [&Rules](int32 Other) { return Rules.IsAlive(Other) && !Rules.IsIncapacitated(Other) && !Rules.IsKiller(Other); });
+					const EHitOutcome Hit = (Victim != INDEX_NONE) ? Rules.Hit(Victim, 1) : EHitOutcome::None;
+					Result.NumKnockdowns += (Hit == EHitOutcome::PassedOut) ? 1 : 0;
+					Result.NumKills += (Hit == EHitOutcome::Died) ? 1 : 0;
+					NumBodies += (Hit == EHitOutcome::Died) ? 1 : 0;
+
+					if ((Hit != EHitOutcome::None) && (Rules.CheckOutcome() == EMatchAction::EndMatch))
+					{
+						return;
+					}
+				}
+				continue;
+			}
+
+			if (Random.FRand() < PerSecond(Tuning.ReviveInterval))
+			{
+				const int32 PassedOut = PickSlot(Rules, Random, [&Rules](int32 Other) { return Rules.IsAlive(Other) && Rules.IsIncapacitated(Other); });
+				Result.NumRevives += ((PassedOut != INDEX_NONE) && Rules.Revive(PassedOut)) ? 1 : 0;
+			}
+
+			if ((NumBodies > 0) && (Random.FRand() < NumBodies * PerSecond(Tuning.ReportInterval)))
+			{
+				Rules.HandleEvent(EMatchEvent::BodyReported);
+				return;
+			}
+
+			if (Random.FRand() < PerSecond(Tuning.MeetingInterval))
+			{
+				Rules.HandleEvent(EMatchEvent::MeetingCalled);
+				return;
+			}
+		}
+	}
+
+	/** Returns how long the vote took. */
+	float SimulateVoting(FPMMatchRules& Rules, const FPlayerTuning& Tuning, FRandomStream& Random)
+	{
+		const FPMMatchRulesConfig& Config = Rules.GetConfig();
+		const float Accuracy = 1.f - FMath::Exp(-Config.DiscussionLength / FMath::Max(Tuning.ClueTime, KINDA_SMALL_NUMBER));
+
+		float LastVoteTime = 0.f;
+		for (int32 Slot = 0; Slot < Rules.GetNumSlots() && Rules.GetState() == ERulesState::Voting; ++Slot)
+		{
+			if (!Rules.IsAlive(Slot))
+			{
+				continue;
+			}
+
+			// exponentially distributed, whoever isn't done in time doesn't vote
+			const float VoteTime = -Tuning.VoteTime * FMath::Loge(FMath::Max(Random.FRand(), KINDA_SMALL_NUMBER));
+			if (VoteTime > Config.VotingLength)
+			{
+				continue;
+			}
+			LastVoteTime = FMath::Max(LastVoteTime, VoteTime);
+
+			int32 Suspect = INDEX_NONE;
+			if (Rules.IsKiller(Slot))
+			{
+				Suspect = PickSlot(Rules, Random, [&Rules](int32 Other) { return Rules.IsAlive(Other) && !Rules.IsKiller(Other); });
+			}
+			else if (Random.FRand() < Accuracy)
+			{
+				Suspect = PickSlot(Rules, Random, [&Rules](int32 Other) { return Rules.IsAlive(Other) && Rules.IsKiller(Other); });
+			}
+			else if (Random.FRand() < 0.5f)
+			{
+				// clueless, half of them guess rather than skip
+				Suspect = PickSlot(Rules, Random, [&Rules, Slot](int32 Other) { return Rules.IsAlive(Other) && (Other != Slot); });
+			}
+
+			Rules.CastVote(Slot, Suspect);
+		}
+
+		if (Rules.GetState() == ERulesState::Voting)
+		{
+			Rules.HandleEvent(EMatchEvent::TimerExpired);
+			return Config.VotingLength;
+		}
+
+		return LastVoteTime;
+	}
+
+	FMatchResult SimulateMatch(const FPMMatchRulesConfig& Config, const FPlayerTuning& Tuning, int32 NumPlayers, int32 Seed)
+	{
+		FPMMatchRules Rules(Config, Seed);
+		FRandomStream Random(Seed);
+		FMatchResult Result;
+
+		for (int32 Index = 0; Index < NumPlayers; ++Index)
+		{
+			Rules.SetReady(Rules.AddPlayer(), true);
+		}
+
+		// nothing to balance in the countdown
+		if (Rules.HandleEvent(EMatchEvent::TimerExpired) != EMatchAction::StartMatch)
+		{
+			return Result;
+		}
+
+		int32 NumBodies = 0;
+		while ((Rules.GetState() != ERulesState::PostMatch) && (Result.Length < Tuning.MaxMatchLength))
+		{
+			switch (Rules.GetState())
+			{
+			case ERulesState::Investigation:
+				Result.Length += 1.f;
+				SimulateInvestigation(Rules, Tuning, Random, NumBodies, Result);
+				break;
+
+			case ERulesState::Discussion:
+				// bodies are cleared away while everyone talks
+				Result.NumMeetings += 1;
+				NumBodies = 0;
+				Result.Length += Rules.GetTimerLength();
+				Rules.HandleEvent(EMatchEvent::TimerExpired);
+				break;
+
+			case ERulesState::Voting:
+				Result.Length += SimulateVoting(Rules, Tuning, Random);
+				if (Rules.GetEjectedPlayer() != INDEX_NONE)
+				{
+					Result.NumEjections += 1;
+					Result.NumKillersEjected += Rules.IsKiller(Rules.GetEjectedPlayer()) ? 1 : 0;
+				}
+				break;
+
+			case ERulesState::Deliberation:
+				Result.Length += Rules.GetTimerLength();
+				Rules.HandleEvent(EMatchEvent::TimerExpired);
+				break;
+
+			default:
+				checkNoEntry();
+				return Result;
+			}
+		}
+
+		Result.Outcome = Rules.GetOutcome();
+		return Result;
+	}
+}
+
+UPMSimulateCommandlet::UPMSimulateCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPMSimulateCommandlet::Main(const FString& Params)
+{
+	FPMMatchRulesConfig Config = GetDefault<APMGameModeBase>()->GetRulesConfig();
+	FParse::Value(*Params, TEXT("HealthMax="), Config.HealthMax);
+	FParse::Value(*Params, TEXT("NumKillers="), Config.NumKillers);
+	FParse::Value(*Params, TEXT("DiscussionLength="), Config.DiscussionLength);
+	FParse::Value(*Params, TEXT("VotingLength="), Config.VotingLength);
+	FParse::Value(*Params, TEXT("DeliberationLength="), Config.DeliberationLength);
+
+	FPlayerTuning Tuning;
+	FParse::Value(*Params, TEXT("KillInterval="), Tuning.KillInterval);
+	FParse::Value(*Params, TEXT("ReportInterval="), Tuning.ReportInterval);
+	FParse::Value(*Params, TEXT("ReviveInterval="), Tuning.ReviveInterval);
+	FParse::Value(*Params, TEXT("MeetingInterval="), Tuning.MeetingInterval);
+	FParse::Value(*Params, TEXT("VoteTime="), Tuning.VoteTime);
+	FParse::Value(*Params, TEXT("ClueTime="), Tuning.ClueTime);
+
+	int32 NumMatches = 100000;
+	int32 NumPlayers = 10;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Matches="), NumMatches);
+	FParse::Value(*Params, TEXT("Players="), NumPlayers);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	if ((NumMatches <= 0) || (NumPlayers < Config.MinNumPlayers))
+	{
+		UE_LOG(LogPuppetMaster, Error, TEXT("Need at least one match of at least %d players"), Config.MinNumPlayers);
+		return 1;
+	}
+
+	UE_LOG(LogPuppetMaster, Display, TEXT("Simulating %d matches of %d players: HealthMax %d, NumKillers %d, DiscussionLength %.0f, VotingLength %.0f, DeliberationLength %.0f"),
+		NumMatches, NumPlayers, Config.HealthMax, Config.NumKillers, Config.DiscussionLength, Config.VotingLength, Config.DeliberationLength);
+
+	TArray<FMatchResult> Results;
+	Results.SetNum(NumMatches);
+
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(NumMatches, [&](int32 Index)
+	{
+		Results[Index] = SimulateMatch(Config, Tuning, NumPlayers, Seed + Index);
+	});
+	const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumKillerWins = 0;
+	int32 NumInnocentWins = 0;
+	double TotalLength = 0.0;
+	int64 TotalMeetings = 0;
+	int64 TotalKnockdowns = 0;
+	int64 TotalKills = 0;
+	int64 TotalRevives = 0;
+	int64 TotalEjections = 0;
+	int64 TotalKillersEjected = 0;
+	for (const FMatchResult& Result : Results)
+	{
+		NumKillerWins += (Result.Outcome == ERulesOutcome::KillersWin) ? 1 : 0;
+		NumInnocentWins += (Result.Outcome == ERulesOutcome::InnocentsWin) ? 1 : 0;
+		TotalLength += Result.Length;
+		TotalMeetings += Result.NumMeetings;
+		TotalKnockdowns += Result.NumKnockdowns;
+		TotalKills += Result.NumKills;
+		TotalRevives += Result.NumRevives;
+		TotalEjections += Result.NumEjections;
+		TotalKillersEjected += Result.NumKillersEjected;
+	}
+
+	const int32 NumStalled = NumMatches - NumKillerWins - NumInnocentWins;
+	UE_LOG(LogPuppetMaster, Display, TEXT("%.0f matches per second (%.2f s)"), NumMatches / FMath::Max(ElapsedTime, 1e-6), ElapsedTime);
+	UE_LOG(LogPuppetMaster, Display, TEXT("Killers win %.1f%%, innocents win %.1f%%, stalled %.1f%%"),
+		100.f * NumKillerWins / NumMatches, 100.f * NumInnocentWins / NumMatches, 100.f * NumStalled / NumMatches);
+	UE_LOG(LogPuppetMaster, Display, TEXT("Per match: %.0f s, %.2f meetings, %.2f knockdowns, %.2f kills, %.2f revives, %.2f ejections (%.1f%% of them killers)"),
+		TotalLength / NumMatches, double(TotalMeetings) / NumMatches, double(TotalKnockdowns) / NumMatches, double(TotalKills) / NumMatches,
+		double(TotalRevives) / NumMatches, double(TotalEjections) / NumMatches, TotalEjections > 0 ? 100.0 * TotalKillersEjected / TotalEjections : 0.0);
+
+	return 0;
+}
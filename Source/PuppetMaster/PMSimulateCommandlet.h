@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "PMSimulateCommandlet.generated.h"
+
+/**
+ * Plays thousands of headless matches on every core with FPMMatchRules and scripted players, for balancing the
+ * game mode's config without a server.
+ * Run with -run=PMSimulate. Rules default to the game mode's config and can be overridden from the command line,
+ * e.g. -HealthMax=1 -DiscussionLength=45. -Matches=, -Players= and -Seed= pick the runs, the player behaviour is
+ * tuned with -KillInterval=, -ReportInterval=, -ReviveInterval=, -MeetingInterval=, -VoteTime= and -ClueTime=.
+ */
+UCLASS()
+class UPMSimulateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UPMSimulateCommandlet();
+
+	int32 Main(const FString& Params) override;
+
+};
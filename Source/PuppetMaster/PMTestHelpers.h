@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** References the automation tests check the optimized code against, kept simple enough to be obviously right. */
+namespace PMTestHelpers
+{
+	/** Even-odd test, a point on the outline can go either way. */
+	inline bool IsInsidePolygon(const FVector2D& Point, TArrayView<const FVector2D> Polygon)
+	{
+		bool bInside = false;
+		for (int32 i = 0, j = Polygon.Num() - 1; i < Polygon.Num(); j = i++)
+		{
+			const FVector2D& A = Polygon[i];
+			const FVector2D& B = Polygon[j];
+			if (((A.Y > Point.Y) != (B.Y > Point.Y)) && (Point.X < A.X + (B.X - A.X) * (Point.Y - A.Y) / (B.Y - A.Y)))
+			{
+				bInside = !bInside;
+			}
+		}
+		return bInside;
+	}
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
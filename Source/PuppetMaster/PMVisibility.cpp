@@ -0,0 +1,250 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMVisibility.h"
+
+namespace
+{
+	// the vision radius is closed off with a polygon so every ray is guaranteed to hit something
+	constexpr int32 NumBoundarySegments = 32;
+
+	struct FSweepEvent
+	{
+		float Angle;
+		int32 SegmentIndex;
+		bool bBegin;
+	};
+
+	float NormalizeAngle(float Angle)
+	{
+		Angle = FMath::Fmod(Angle, 2.f * PI);
+		return (Angle < 0.f) ? Angle + 2.f * PI : Angle;
+	}
+
+	/** Distance along the ray to the segment's supporting line, or MAX_flt if they don't meet in front of the origin. */
+	float RayDistanceToSegment(const FVector2D& Origin, const FVector2D& Direction, const FPMWallSegment& Segment)
+	{
+		const FVector2D Edge = Segment.End - Segment.Start;
+		const float Denominator = FVector2D::CrossProduct(Direction, Edge);
+		if (FMath::IsNearlyZero(Denominator))
+		{
+			return MAX_flt;
+		}
+
+		const float Distance = FVector2D::CrossProduct(Segment.Start - Origin, Edge) / Denominator;
+		return (Distance >= 0.f) ? Distance : MAX_flt;
+	}
+
+	FVector2D AngleToDirection(float Angle)
+	{
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, Angle);
+		return FVector2D(Cos, Sin);
+	}
+
+	/** Trims the segment to the part inside the circle. Returns false if nothing is left. */
+	bool ClipToCircle(const FVector2D& Center, float Radius, FPMWallSegment& Segment)
+	{
+		const FVector2D Edge = Segment.End - Segment.Start;
+		const FVector2D FromCenter = Segment.Start - Center;
+
+		const float A = Edge.SizeSquared();
+		const float B = 2.f * (FromCenter | Edge);
+		const float C = FromCenter.SizeSquared() - FMath::Square(Radius);
+
+		const float Discriminant = FMath::Square(B) - 4.f * A * C;
+		if (A <= SMALL_NUMBER || Discriminant <= 0.f)
+		{
+			return false;
+		}
+
+		const float Root = FMath::Sqrt(Discriminant);
+		const float EnterAlpha = FMath::Max(0.f, (-B - Root) / (2.f * A));
+		const float ExitAlpha = FMath::Min(1.f, (-B + Root) / (2.f * A));
+		if (EnterAlpha >= ExitAlpha)
+		{
+			return false;
+		}
+
+		const FVector2D Start = Segment.Start;
+		Segment.Start = Start + Edge * EnterAlpha;
+		Segment.End = Start + Edge * ExitAlpha;
+		return true;
+	}
+}
+
+void PMVisibility::ComputeVisibilityPolygon(const FVector2D& Origin, float Radius, float StartAngle, float Span, TArrayView<const FPMWallSegment> Segments, TArray<FVector2D>& OutPolygon)
+{
+	check(Radius > 0.f);
+
+	OutPolygon.Reset();
+
+	Span = FMath::Clamp(Span, 0.f, 2.f * PI);
+	const bool bFullCircle = FMath::IsNearlyEqual(Span, 2.f * PI);
+
+	// the sweep assumes segments never cross, so walls are trimmed to the circle inscribed in the boundary polygon.
+	// overlapping walls in the level can still cross each other; that only costs a little accuracy right at the crossing.
+	const float InscribedRadius = Radius * FMath::Cos(PI / NumBoundarySegments);
+
+	TArray<FPMWallSegment, TInlineAllocator<128>> Working;
+	Working.Reserve(Segments.Num() + NumBoundarySegments);
+	for (const FPMWallSegment& Segment : Segments)
+	{
+		FPMWallSegment Clipped = Segment;
+		if (ClipToCircle(Origin, InscribedRadius, Clipped))
+		{
+			Working.Add(Clipped);
+		}
+	}
+
+	for (int32 i = 0; i < NumBoundarySegments; ++i)
+	{
+		const float AngleA = (2.f * PI * i) / NumBoundarySegments;
+		const float AngleB = (2.f * PI * (i + 1)) / NumBoundarySegments;
+		Working.Emplace(Origin + AngleToDirection(AngleA) * Radius, Origin + AngleToDirection(AngleB) * Radius);
+	}
+
+	TArray<FSweepEvent, TInlineAllocator<256>> Events;
+	Events.Reserve(Working.Num() * 2);
+
+	TArray<int32, TInlineAllocator<32>> Active;
+
+	for (int32 SegmentIndex = 0; SegmentIndex < Working.Num(); ++SegmentIndex)
+	{
+		const FVector2D ToStart = Working[SegmentIndex].Start - Origin;
+		const FVector2D ToEnd = Working[SegmentIndex].End - Origin;
+
+		// segments seen edge-on don't occlude anything
+		const float Winding = FVector2D::CrossProduct(ToStart, ToEnd);
+		if (FMath::IsNearlyZero(Winding))
+		{
+			continue;
+		}
+
+		const float StartPointAngle = NormalizeAngle(FMath::Atan2(ToStart.Y, ToStart.X) - StartAngle);
+		const float EndPointAngle = NormalizeAngle(FMath::Atan2(ToEnd.Y, ToEnd.X) - StartAngle);
+
+		const float BeginAngle = (Winding > 0.f) ? StartPointAngle : EndPointAngle;
+		const float EndAngle = (Winding > 0.f) ? EndPointAngle : StartPointAngle;
+
+		if (BeginAngle > EndAngle)
+		{
+			// straddles the start of the sweep, so it is seen again right before a full circle closes
+			Active.Add(SegmentIndex);
+		}
+
+		Events.Add({ BeginAngle, SegmentIndex, true });
+		Events.Add({ EndAngle, SegmentIndex, false });
+	}
+
+	Events.Sort([](const FSweepEvent& A, const FSweepEvent& B) { return A.Angle < B.Angle; });
+
+	auto FindNearest = [&](float Angle)
+	{
+		const FVector2D Direction = AngleToDirection(StartAngle + Angle);
+
+		int32 Nearest = INDEX_NONE;
+		float NearestDistance = MAX_flt;
+		for (int32 SegmentIndex : Active)
+		{
+			const float Distance = RayDistanceToSegment(Origin, Direction, Working[SegmentIndex]);
+			if (Distance < NearestDistance)
+			{
+				NearestDistance = Distance;
+				Nearest = SegmentIndex;
+			}
+		}
+		return Nearest;
+	};
+
+	auto EmitPoint = [&](float Angle, int32 SegmentIndex)
+	{
+		const FVector2D Direction = AngleToDirection(StartAngle + Angle);
+		float Distance = (SegmentIndex != INDEX_NONE) ? RayDistanceToSegment(Origin, Direction, Working[SegmentIndex]) : Radius;
+		Distance = FMath::Min(Distance, Radius);
+		OutPolygon.Add(Origin + Direction * Distance);
+	};
+
+	int32 EventIndex = 0;
+	auto ApplyEventsUpTo = [&](float Angle)
+	{
+		for (; EventIndex < Events.Num() && Events[EventIndex].Angle <= Angle + KINDA_SMALL_NUMBER; ++EventIndex)
+		{
+			const FSweepEvent& Event = Events[EventIndex];
+			if (Event.bBegin)
+			{
+				Active.Add(Event.SegmentIndex);
+			}
+			else
+			{
+				Active.RemoveSingleSwap(Event.SegmentIndex, false);
+			}
+		}
+	};
+
+	auto NextEventAngle = [&]()
+	{
+		return (EventIndex < Events.Num()) ? FMath::Min(Events[EventIndex].Angle, Span) : Span;
+	};
+
+	if (!bFullCircle)
+	{
+		OutPolygon.Add(Origin);
+	}
+
+	ApplyEventsUpTo(0.f);
+
+	// rays are cast between events, never exactly through an endpoint
+	int32 Previous = FindNearest(0.5f * NextEventAngle());
+	EmitPoint(0.f, Previous);
+
+	while (EventIndex < Events.Num() && Events[EventIndex].Angle < Span)
+	{
+		const float Angle = Events[EventIndex].Angle;
+		ApplyEventsUpTo(Angle);
+
+		const int32 Nearest = FindNearest(0.5f * (Angle + NextEventAngle()));
+		if (Nearest != Previous)
+		{
+			EmitPoint(Angle, Previous);
+			EmitPoint(Angle, Nearest);
+			Previous = Nearest;
+		}
+	}
+
+	if (!bFullCircle)
+	{
+		EmitPoint(Span, Previous);
+	}
+}
+
+bool PMVisibility::SegmentsIntersect(const FVector2D& A, const FVector2D& B, const FVector2D& C, const FVector2D& D)
+{
+	const float ABC = FVector2D::CrossProduct(B - A, C - A);
+	const float ABD = FVector2D::CrossProduct(B - A, D - A);
+	const float CDA = FVector2D::CrossProduct(D - C, A - C);
+	const float CDB = FVector2D::CrossProduct(D - C, B - C);
+
+	return ((ABC > 0.f) != (ABD > 0.f)) && ((CDA > 0.f) != (CDB > 0.f));
+}
+
+bool PMVisibility::HasLineOfSight(const FVector2D& From, const FVector2D& To, TArrayView<const FPMWallSegment> Segments)
+{
+	for (const FPMWallSegment& Segment : Segments)
+	{
+		if (SegmentsIntersect(From, To, Segment.Start, Segment.End))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+float PMVisibility::DistanceToSegment(const FVector2D& Point, const FPMWallSegment& Segment)
+{
+	const FVector2D Edge = Segment.End - Segment.Start;
+	const float LengthSquared = Edge.SizeSquared();
+	const float Alpha = (LengthSquared > SMALL_NUMBER) ? FMath::Clamp(((Point - Segment.Start) | Edge) / LengthSquared, 0.f, 1.f) : 0.f;
+
+	return FVector2D::Distance(Point, Segment.Start + Edge * Alpha);
+}
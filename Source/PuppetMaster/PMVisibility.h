@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** A single occluding wall edge, projected onto the movement plane. */
+struct FPMWallSegment
+{
+	FVector2D Start;
+	FVector2D End;
+
+	FPMWallSegment() = default;
+	FPMWallSegment(const FVector2D& InStart, const FVector2D& InEnd) : Start(InStart), End(InEnd) {}
+};
+
+namespace PMVisibility
+{
+	/**
+	 * Computes the polygon visible from Origin with a single angular sweep over the segment endpoints.
+	 * The sector starts at StartAngle and spans Span radians counter clockwise; anything past Radius is clipped.
+	 * Points are written counter clockwise. For sectors narrower than a full circle the first point is Origin.
+	 */
+	void ComputeVisibilityPolygon(const FVector2D& Origin, float Radius, float StartAngle, float Span, TArrayView<const FPMWallSegment> Segments, TArray<FVector2D>& OutPolygon);
+
+	bool SegmentsIntersect(const FVector2D& A, const FVector2D& B, const FVector2D& C, const FVector2D& D);
+
+	bool HasLineOfSight(const FVector2D& From, const FVector2D& To, TArrayView<const FPMWallSegment> Segments);
+
+	float DistanceToSegment(const FVector2D& Point, const FPMWallSegment& Segment);
+}
@@ -0,0 +1,151 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMVisibilitySubsystem.h"
+
+#include "PMCharacter.h"
+#include "PMGameMode.h"
+#include "PMMatch.h"
+#include "PMOccluderSubsystem.h"
+#include "PMPlayerController.h"
+#include "PuppetMaster.h"
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarLoSRelevancy(
+	TEXT("pm.LoSRelevancy"),
+	1,
+	TEXT("Only replicate puppets to players whose puppet can see them during investigation.\n")
+	TEXT("0: distance based relevancy, 1: line of sight relevancy (default)"));
+
+DECLARE_CYCLE_STAT(TEXT("Update Visibility"), STAT_PMUpdateVisibility, STATGROUP_PuppetMaster);
+
+void UPMVisibilitySubsystem::RegisterCharacter(APMCharacter& Character)
+{
+	check(Character.VisibilityIndex == INDEX_NONE);
+
+	Character.VisibilityIndex = Characters.Add(&Character);
+	LastUpdateFrame = MAX_uint64;
+}
+
+void UPMVisibilitySubsystem::UnregisterCharacter(APMCharacter& Character)
+{
+	const int32 Index = Character.VisibilityIndex;
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	check(Characters[Index] == &Character);
+
+	Characters.RemoveAtSwap(Index, 1, false);
+	if (Characters.IsValidIndex(Index))
+	{
+		Characters[Index]->VisibilityIndex = Index;
+	}
+
+	Character.VisibilityIndex = INDEX_NONE;
+	LastUpdateFrame = MAX_uint64;
+}
+
+bool UPMVisibilitySubsystem::CanSee(const APMCharacter& Viewer, const APMCharacter& Target)
+{
+	if (&Viewer == &Target)
+	{
+		return true;
+	}
+
+	check((Viewer.VisibilityIndex != INDEX_NONE) && (Target.VisibilityIndex != INDEX_NONE));
+
+	if (LastUpdateFrame != GFrameCounter)
+	{
+		UpdateVisibility();
+	}
+
+	return Visibility[Viewer.VisibilityIndex * Characters.Num() + Target.VisibilityIndex];
+}
+
+const APMCharacter* UPMVisibilitySubsystem::GetLineOfSightViewer(const AActor* RealViewer, const APMMatch* ViewerMatch) const
+{
+	if ((CVarLoSRelevancy.GetValueOnGameThread() == 0) || !ViewerMatch || !ViewerMatch->InMatchState(EMatchState::Investigation))
+	{
+		return nullptr;
+	}
+
+	const APMPlayerController* Viewer = Cast<APMPlayerController>(RealViewer);
+	const APMCharacter* ViewerPawn = Viewer ? Cast<APMCharacter>(Viewer->GetSimulatedPawn()) : nullptr;
+	if (!IsValid(ViewerPawn) || !ViewerPawn->IsAlive() || (ViewerPawn->VisibilityIndex == INDEX_NONE))
+	{
+		return nullptr;
+	}
+
+	return ViewerPawn;
+}
+
+bool UPMVisibilitySubsystem::IsHiddenFrom(const AActor* RealViewer, const APMCharacter& Target)
+{
+	const APMMatch* ViewerMatch = APMMatch::GetViewerMatch(RealViewer);
+	if (ViewerMatch && Target.GetMatch() && (ViewerMatch != Target.GetMatch()))
+	{
+		return true;
+	}
+
+	const APMCharacter* ViewerPawn = GetLineOfSightViewer(RealViewer, ViewerMatch);
+	if (!ViewerPawn || (Target.VisibilityIndex == INDEX_NONE))
+	{
+		return false;
+	}
+
+	return !CanSee(*ViewerPawn, Target);
+}
+
+void UPMVisibilitySubsystem::UpdateVisibility()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PMUpdateVisibility);
+	CSV_SCOPED_TIMING_STAT(PuppetMaster, UpdateVisibility);
+
+	LastUpdateFrame = GFrameCounter;
+
+	UPMOccluderSubsystem* Occluders = GetWorld()->GetSubsystem<UPMOccluderSubsystem>();
+	check(Occluders);
+
+	const int32 NumCharacters = Characters.Num();
+	Visibility.Init(false, NumCharacters * NumCharacters);
+
+	TArray<FVector, TInlineAllocator<32>> Locations;
+	TArray<float, TInlineAllocator<32>> RadiiSquared;
+	for (const APMCharacter* Character : Characters)
+	{
+		Locations.Add(Character->GetActorLocation());
+		RadiiSquared.Add(FMath::Square(Character->GetVisionRadius()));
+	}
+
+	// line of sight is symmetric, so each pair is traced once and only the vision radius differs per direction
+	for (int32 i = 0; i < NumCharacters; ++i)
+	{
+		Visibility[i * NumCharacters + i] = true;
+
+		for (int32 j = i + 1; j < NumCharacters; ++j)
+		{
+			// puppets of different matches never see each other
+			if (Characters[i]->GetMatch() != Characters[j]->GetMatch())
+			{
+				continue;
+			}
+
+			const float DistanceSquared = FVector::DistSquared2D(Locations[i], Locations[j]);
+			if ((DistanceSquared > RadiiSquared[i]) && (DistanceSquared > RadiiSquared[j]))
+			{
+				continue;
+			}
+
+			if (!Occluders->HasLineOfSight(Locations[i], Locations[j]))
+			{
+				continue;
+			}
+
+			Visibility[i * NumCharacters + j] = (DistanceSquared <= RadiiSquared[i]);
+			Visibility[j * NumCharacters + i] = (DistanceSquared <= RadiiSquared[j]);
+		}
+	}
+}
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PMVisibilitySubsystem.generated.h"
+
+class APMCharacter;
+class APMMatch;
+
+/**
+ * Server side answer to "can this puppet see that one". All pairs are resolved together in one pass over the
+ * occluder grid the first time they're asked for in a frame, so net relevancy checks are a bit lookup.
+ */
+UCLASS()
+class UPMVisibilitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	void RegisterCharacter(APMCharacter& Character);
+	void UnregisterCharacter(APMCharacter& Character);
+
+	/** Both puppets have to be registered. */
+	bool CanSee(const APMCharacter& Viewer, const APMCharacter& Target);
+
+	/**
+	 * The puppet whose line of sight limits what RealViewer gets to see of ViewerMatch, or null if it sees everything
+	 * in it. Line of sight only applies during investigation; players without a living puppet keep seeing everything.
+	 */
+	const APMCharacter* GetLineOfSightViewer(const AActor* RealViewer, const APMMatch* ViewerMatch) const;
+
+	/** True if Target should not be replicated to the connection RealViewer belongs to. Puppets of other matches are always hidden. */
+	bool IsHiddenFrom(const AActor* RealViewer, const APMCharacter& Target);
+
+private:
+
+	void UpdateVisibility();
+
+	UPROPERTY(Transient)
+	TArray<APMCharacter*> Characters;
+
+	/** Row per viewer, column per target, in Characters order, see APMCharacter::VisibilityIndex. */
+	TBitArray<> Visibility;
+
+	uint64 LastUpdateFrame = MAX_uint64;
+
+};
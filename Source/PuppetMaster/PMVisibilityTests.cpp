@@ -0,0 +1,177 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMVisibility.h"
+
+#include "PMTestHelpers.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PMVisibilityTests
+{
+	constexpr float Radius = 1000.f;
+	constexpr float SampleStep = 20.f;
+
+	// samples this close to a wall or to the polygon's outline could land either side of it through rounding alone
+	constexpr float Tolerance = 2.f;
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		FVector2D Origin;
+		float StartAngle;
+		float Span;
+		TArray<FPMWallSegment> Walls;
+	};
+
+	void AddBox(TArray<FPMWallSegment>& Walls, const FVector2D& Min, const FVector2D& Max)
+	{
+		Walls.Emplace(FVector2D(Min.X, Min.Y), FVector2D(Max.X, Min.Y));
+		Walls.Emplace(FVector2D(Max.X, Min.Y), FVector2D(Max.X, Max.Y));
+		Walls.Emplace(FVector2D(Max.X, Max.Y), FVector2D(Min.X, Max.Y));
+		Walls.Emplace(FVector2D(Min.X, Max.Y), FVector2D(Min.X, Min.Y));
+	}
+
+	TArray<FCase> MakeCases()
+	{
+		TArray<FCase> Cases;
+
+		Cases.Add({ TEXT("Open"), FVector2D::ZeroVector, 0.f, 2.f * PI, {} });
+
+		FCase SingleWall{ TEXT("SingleWall"), FVector2D::ZeroVector, 0.f, 2.f * PI, {} };
+		SingleWall.Walls.Emplace(FVector2D(200.f, -300.f), FVector2D(250.f, 300.f));
+		Cases.Add(SingleWall);
+
+		// a room with a doorway in its east wall, seen from inside and from outside
+		TArray<FPMWallSegment> Room;
+		Room.Emplace(FVector2D(-400.f, -400.f), FVector2D(400.f, -400.f));
+		Room.Emplace(FVector2D(400.f, -400.f), FVector2D(400.f, -60.f));
+		Room.Emplace(FVector2D(400.f, 60.f), FVector2D(400.f, 400.f));
+		Room.Emplace(FVector2D(400.f, 400.f), FVector2D(-400.f, 400.f));
+		Room.Emplace(FVector2D(-400.f, 400.f), FVector2D(-400.f, -400.f));
+
+		Cases.Add({ TEXT("RoomInside"), FVector2D(-100.f, 30.f), 0.f, 2.f * PI, Room });
+		Cases.Add({ TEXT("RoomOutside"), FVector2D(700.f, -150.f), 0.f, 2.f * PI, Room });
+
+		FCase Pillars{ TEXT("Pillars"), FVector2D(10.f, -20.f), 0.f, 2.f * PI, {} };
+		AddBox(Pillars.Walls, FVector2D(150.f, 100.f), FVector2D(250.f, 200.f));
+		AddBox(Pillars.Walls, FVector2D(-300.f, -50.f), FVector2D(-200.f, 50.f));
+		AddBox(Pillars.Walls, FVector2D(-80.f, -500.f), FVector2D(80.f, -350.f));
+		AddBox(Pillars.Walls, FVector2D(500.f, -300.f), FVector2D(600.f, 300.f));
+		Pillars.Walls.Emplace(FVector2D(-600.f, 300.f), FVector2D(-100.f, 650.f));
+		Cases.Add(Pillars);
+
+		// the same pillars through a cone that wraps past angle zero
+		FCase Cone = Pillars;
+		Cone.Name = TEXT("PillarsCone");
+		Cone.StartAngle = -0.75f * PI;
+		Cone.Span = PI;
+		Cases.Add(Cone);
+
+		return Cases;
+	}
+
+	bool IsNearOutline(const FVector2D& Point, const TArray<FVector2D>& Polygon)
+	{
+		for (int32 i = 0, j = Polygon.Num() - 1; i < Polygon.Num(); j = i++)
+		{
+			if (PMVisibility::DistanceToSegment(Point, FPMWallSegment(Polygon[j], Polygon[i])) < Tolerance)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool IsNearWall(const FVector2D& Point, const TArray<FPMWallSegment>& Walls)
+	{
+		return Walls.ContainsByPredicate([&Point](const FPMWallSegment& Wall) { return PMVisibility::DistanceToSegment(Point, Wall) < Tolerance; });
+	}
+
+	bool IsInSector(const FVector2D& Origin, const FVector2D& Point, float StartAngle, float Span)
+	{
+		const FVector2D ToPoint = Point - Origin;
+		float Angle = FMath::Fmod(FMath::Atan2(ToPoint.Y, ToPoint.X) - StartAngle, 2.f * PI);
+		if (Angle < 0.f)
+		{
+			Angle += 2.f * PI;
+		}
+		return Angle <= Span;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMSegmentsIntersectTest, "PuppetMaster.Visibility.SegmentsIntersect", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMSegmentsIntersectTest::RunTest(const FString& Parameters)
+{
+	using namespace PMVisibility;
+
+	TestTrue(TEXT("Crossing"), SegmentsIntersect(FVector2D(0.f, 0.f), FVector2D(10.f, 10.f), FVector2D(0.f, 10.f), FVector2D(10.f, 0.f)));
+	TestFalse(TEXT("Parallel"), SegmentsIntersect(FVector2D(0.f, 0.f), FVector2D(10.f, 0.f), FVector2D(0.f, 1.f), FVector2D(10.f, 1.f)));
+	TestFalse(TEXT("Short of each other"), SegmentsIntersect(FVector2D(0.f, 0.f), FVector2D(4.f, 4.f), FVector2D(0.f, 10.f), FVector2D(10.f, 0.f)));
+	TestFalse(TEXT("Collinear"), SegmentsIntersect(FVector2D(0.f, 0.f), FVector2D(10.f, 0.f), FVector2D(5.f, 0.f), FVector2D(15.f, 0.f)));
+
+	const TArray<FPMWallSegment> Walls = { FPMWallSegment(FVector2D(5.f, -5.f), FVector2D(5.f, 5.f)) };
+	TestFalse(TEXT("Blocked"), HasLineOfSight(FVector2D(0.f, 0.f), FVector2D(10.f, 0.f), Walls));
+	TestTrue(TEXT("Around the end"), HasLineOfSight(FVector2D(0.f, 0.f), FVector2D(10.f, 20.f), Walls));
+	TestTrue(TEXT("Stops short"), HasLineOfSight(FVector2D(0.f, 0.f), FVector2D(4.f, 0.f), Walls));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPMVisibilityPolygonTest, "PuppetMaster.Visibility.PolygonMatchesLineOfSight", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPMVisibilityPolygonTest::RunTest(const FString& Parameters)
+{
+	using namespace PMVisibilityTests;
+
+	// the polygon closes the radius off with a 32 sided boundary, so only sample well inside it
+	const float SampleRadius = 0.95f * Radius;
+
+	TArray<FVector2D> Polygon;
+	for (const FCase& Case : MakeCases())
+	{
+		PMVisibility::ComputeVisibilityPolygon(Case.Origin, Radius, Case.StartAngle, Case.Span, Case.Walls, Polygon);
+		if (!TestTrue(FString::Printf(TEXT("%s has a polygon"), Case.Name), Polygon.Num() >= 3))
+		{
+			continue;
+		}
+
+		int32 NumSamples = 0;
+		int32 NumMismatches = 0;
+		for (float X = -SampleRadius; X <= SampleRadius; X += SampleStep)
+		{
+			for (float Y = -SampleRadius; Y <= SampleRadius; Y += SampleStep)
+			{
+				const FVector2D Point = Case.Origin + FVector2D(X, Y);
+				if ((FVector2D::Distance(Point, Case.Origin) > SampleRadius) || IsNearWall(Point, Case.Walls) || IsNearOutline(Point, Polygon))
+				{
+					continue;
+				}
+
+				const bool bExpected = IsInSector(Case.Origin, Point, Case.StartAngle, Case.Span) && PMVisibility::HasLineOfSight(Case.Origin, Point, Case.Walls);
+				const bool bInside = PMTestHelpers::IsInsidePolygon(Point, Polygon);
+
+				++NumSamples;
+				if (bExpected != bInside)
+				{
+					// one message per case is enough to find it, the count says how bad it is
+					if (NumMismatches == 0)
+					{
+						AddError(FString::Printf(TEXT("%s: (%.1f, %.1f) is %s the polygon but %s"), Case.Name, Point.X, Point.Y,
+							bInside ? TEXT("inside") : TEXT("outside"), bExpected ? TEXT("visible") : TEXT("hidden")));
+					}
+					++NumMismatches;
+				}
+			}
+		}
+
+		TestTrue(FString::Printf(TEXT("%s sampled anything"), Case.Name), NumSamples > 0);
+		TestEqual(FString::Printf(TEXT("%s mismatches out of %d samples"), Case.Name, NumSamples), NumMismatches, 0);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,161 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PMVoteTracker.h"
+
+#include "PMMatch.h"
+#include "PMMatchRules.h"
+#include "PMPlayerController.h"
+
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+bool FPMBallot::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bPackedVoted = bVoted ? 1 : 0;
+
+	Ar << Slot;
+	Ar.SerializeBits(&bPackedVoted, 1);
+	Ar << Suspect;
+
+	if (Ar.IsLoading())
+	{
+		bVoted = (bPackedVoted != 0);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+UPMVoteTracker::UPMVoteTracker()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UPMVoteTracker::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(UPMVoteTracker, Ballots, Params);
+}
+
+void UPMVoteTracker::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	PushModelValidator.Validate(*this);
+}
+
+void UPMVoteTracker::OpenVoting(int32 NumSlots)
+{
+	static_assert(FPMMatchRules::MaxSlots <= FPMBallot::NoSuspect, "Every slot needs a ballot, and nobody needs a value of their own");
+	check(NumSlots <= FPMMatchRules::MaxSlots);
+
+	for (FPMBallot& Ballot : Ballots.Ballots)
+	{
+		if (Ballot.bVoted || (Ballot.Suspect != FPMBallot::NoSuspect))
+		{
+			Ballot.bVoted = false;
+			Ballot.Suspect = FPMBallot::NoSuspect;
+			MarkBallotDirty(Ballot);
+		}
+	}
+
+	// players who joined since last round
+	while (Ballots.Ballots.Num() < NumSlots)
+	{
+		FPMBallot& Ballot = Ballots.Ballots.AddDefaulted_GetRef();
+		Ballot.Slot = static_cast<uint8>(Ballots.Ballots.Num() - 1);
+		MarkBallotDirty(Ballot);
+	}
+}
+
+void UPMVoteTracker::SetVoted(int32 Slot, bool bVoted)
+{
+	if (Ballots.Ballots.IsValidIndex(Slot) && (Ballots.Ballots[Slot].bVoted != bVoted))
+	{
+		FPMBallot& Ballot = Ballots.Ballots[Slot];
+		Ballot.bVoted = bVoted;
+		MarkBallotDirty(Ballot);
+	}
+}
+
+void UPMVoteTracker::ResetVotes()
+{
+	if (Ballots.Ballots.Num() > 0)
+	{
+		Ballots.Ballots.Reset();
+		Ballots.MarkArrayDirty();
+		PM_MARK_PROPERTY_DIRTY(UPMVoteTracker, Ballots);
+	}
+}
+
+void UPMVoteTracker::RevealVotes(const FPMMatchRules& Rules)
+{
+	for (FPMBallot& Ballot : Ballots.Ballots)
+	{
+		const int32 Suspect = Rules.HasVoted(Ballot.Slot) ? Rules.GetVote(Ballot.Slot) : INDEX_NONE;
+		const uint8 PackedSuspect = (Suspect != INDEX_NONE) ? static_cast<uint8>(Suspect) : FPMBallot::NoSuspect;
+		if (Ballot.Suspect != PackedSuspect)
+		{
+			Ballot.Suspect = PackedSuspect;
+			MarkBallotDirty(Ballot);
+		}
+	}
+}
+
+EPlayerVoteStatus UPMVoteTracker::GetVoteStatus(const APMPlayerState* Player) const
+{
+	const FPMBallot* Ballot = Player ? FindBallot(Player->GetMatchSlot()) : nullptr;
+	return (Ballot && Ballot->bVoted) ? EPlayerVoteStatus::Voted : EPlayerVoteStatus::NoVote;
+}
+
+APMPlayerState* UPMVoteTracker::GetRevealedVote(const APMPlayerState* Player) const
+{
+	const FPMBallot* Ballot = Player ? FindBallot(Player->GetMatchSlot()) : nullptr;
+	if (!Ballot || (Ballot->Suspect == FPMBallot::NoSuspect))
+	{
+		return nullptr;
+	}
+
+	for (APlayerState* Other : GetWorld()->GetGameState()->PlayerArray)
+	{
+		APMPlayerState* Suspect = Cast<APMPlayerState>(Other);
+		if (Suspect && (Suspect->GetMatch() == GetOwner()) && (Suspect->GetMatchSlot() == Ballot->Suspect))
+		{
+			return Suspect;
+		}
+	}
+
+	return nullptr;
+}
+
+int32 UPMVoteTracker::GetNumVotes() const
+{
+	int32 NumVotes = 0;
+	for (const FPMBallot& Ballot : Ballots.Ballots)
+	{
+		NumVotes += Ballot.bVoted ? 1 : 0;
+	}
+	return NumVotes;
+}
+
+const FPMBallot* UPMVoteTracker::FindBallot(int32 Slot) const
+{
+	if (Ballots.Ballots.IsValidIndex(Slot) && (Ballots.Ballots[Slot].Slot == Slot))
+	{
+		return &Ballots.Ballots[Slot];
+	}
+
+	return Ballots.Ballots.FindByPredicate([Slot](const FPMBallot& Ballot) { return Ballot.Slot == Slot; });
+}
+
+void UPMVoteTracker::MarkBallotDirty(FPMBallot& Ballot)
+{
+	Ballots.MarkItemDirty(Ballot);
+	PM_MARK_PROPERTY_DIRTY(UPMVoteTracker, Ballots);
+}
@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "PMMatchTypes.h"
+#include "PMPushModel.h"
+
+#include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+
+#include "PMVoteTracker.generated.h"
+
+class APMPlayerState;
+class FPMMatchRules;
+
+/** One player's ballot. Who it names is only filled in once voting has closed, until then it only says it was cast. */
+USTRUCT()
+struct FPMBallot : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	static constexpr uint8 NoSuspect = 0xFF;
+
+	UPROPERTY()
+	uint8 Slot = 0;
+
+	UPROPERTY()
+	bool bVoted = false;
+
+	/** Slot of the suspect, NoSuspect for a skip or while voting is open. */
+	UPROPERTY()
+	uint8 Suspect = NoSuspect;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPMBallot> : public TStructOpsTypeTraitsBase2<FPMBallot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** A ballot per player slot, only the ones that changed are sent. */
+USTRUCT()
+struct FPMBallotArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FPMBallot, FPMBallotArray>(Ballots, DeltaParms, *this);
+	}
+
+	/** On the server ballots sit at their slot, clients receive them in any order. */
+	UPROPERTY()
+	TArray<FPMBallot> Ballots;
+};
+
+template<>
+struct TStructOpsTypeTraits<FPMBallotArray> : public TStructOpsTypeTraitsBase2<FPMBallotArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Shows the players of a match how the vote is going. The votes themselves are counted by FPMMatchRules on the
+ * server; this only replicates who has voted while voting is open, and who they voted for once it closed.
+ * Changing a vote resends that one ballot, so it stays cheap with many players changing their minds.
+ */
+UCLASS()
+class UPMVoteTracker : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UPMVoteTracker();
+
+	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** Server only, hands every slot an empty ballot. */
+	void OpenVoting(int32 NumSlots);
+	void SetVoted(int32 Slot, bool bVoted);
+
+	/** Server only, throws every ballot away for the next match, whose players get new slots. */
+	void ResetVotes();
+
+	/** Server only, shows who voted for whom once the rules have counted. */
+	void RevealVotes(const FPMMatchRules& Rules);
+
+	UFUNCTION(BlueprintPure)
+	EPlayerVoteStatus GetVoteStatus(const APMPlayerState* Player) const;
+
+	/** Who Player voted for, null for a skip or while voting is open. */
+	UFUNCTION(BlueprintPure)
+	APMPlayerState* GetRevealedVote(const APMPlayerState* Player) const;
+
+	UFUNCTION(BlueprintPure)
+	int32 GetNumVotes() const;
+
+private:
+
+	const FPMBallot* FindBallot(int32 Slot) const;
+	void MarkBallotDirty(FPMBallot& Ballot);
+
+	UPROPERTY(Replicated)
+	FPMBallotArray Ballots;
+
+	FPMPushModelValidator PushModelValidator;
+
+};
@@ -11,7 +11,7 @@ public class PuppetMaster : ModuleRules
         PublicDependencyModuleNames.AddRange(new string[] 
 		{ 
 			"Core", "CoreUObject", "Engine", "InputCore",
-			"NavigationSystem", "AIModule",
+			"NavigationSystem", "AIModule", "ReplicationGraph", "NetCore", "SignificanceManager",
 		});
     }
 }
@@ -6,4 +6,6 @@
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PuppetMaster, "PuppetMaster" );
 
 DEFINE_LOG_CATEGORY(LogPuppetMaster)
+
+CSV_DEFINE_CATEGORY(PuppetMaster, true);
  
\ No newline at end of file
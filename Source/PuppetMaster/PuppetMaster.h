@@ -3,7 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogPuppetMaster, Log, All);
 
-#define LogPuppetMaster
\ No newline at end of file
+/** Shown with "stat PuppetMaster". */
+DECLARE_STATS_GROUP(TEXT("PuppetMaster"), STATGROUP_PuppetMaster, STATCAT_Advanced);
+
+/** Picked up by csvprofile captures, e.g. -csvCategories=PuppetMaster. */
+CSV_DECLARE_CATEGORY_EXTERN(PuppetMaster);
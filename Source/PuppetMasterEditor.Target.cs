@@ -9,6 +9,7 @@ public class PuppetMasterEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
+		bWithPushModel = true;
 		ExtraModuleNames.Add("PuppetMaster");
 	}
 }